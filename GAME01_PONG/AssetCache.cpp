@@ -0,0 +1,218 @@
+#include "AssetCache.h"
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include <stb_image.h>
+
+namespace fs
+{
+
+namespace
+{
+
+struct DecodedImage {
+    std::string Key;
+    uint64_t ContentHash;
+    std::vector<unsigned char> Bytes; // the file, to tell a hash collision from a duplicate
+    std::unique_ptr<gfx::Image> Image;
+};
+
+std::vector<unsigned char> ReadFile(const std::string& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    return std::vector<unsigned char>{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+}
+
+// FNV-1a over 8 byte words, then the remaining bytes: only a filter, equal hashes are compared byte for byte
+uint64_t HashContent(const std::vector<unsigned char>& bytes) noexcept
+{
+    constexpr uint64_t prime = 0x100000001b3ull;
+    uint64_t hash = 0xcbf29ce484222325ull ^ bytes.size();
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, sizeof(word));
+        hash ^= word;
+        hash *= prime;
+        hash ^= hash >> 32;
+    }
+    for (; i < bytes.size(); ++i) {
+        hash ^= bytes[i];
+        hash *= prime;
+    }
+    return hash;
+}
+
+// runs on a worker: file read, hash and decode, no GL call
+DecodedImage Decode(std::string key)
+{
+    auto bytes = ReadFile(key);
+
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    unsigned char* data = bytes.empty() ? nullptr
+        : stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &components, 4);
+    if (data == nullptr) {
+        return DecodedImage{ std::move(key), 0, {}, nullptr };
+    }
+
+    auto hash = HashContent(bytes);
+    return DecodedImage{ std::move(key), hash, std::move(bytes), std::make_unique<gfx::Image>(width, height, data) };
+}
+
+}
+
+AssetCache::~AssetCache()
+{
+    for (const auto& [key, index] : m_ByPath) {
+        m_Textures.Release(m_Assets[index].Texture.Texture);
+    }
+}
+
+size_t AssetCache::AddAsset(Asset asset)
+{
+    if (m_FreeAssets.empty()) {
+        m_Assets.push_back(std::move(asset));
+        return m_Assets.size() - 1;
+    }
+    auto index = m_FreeAssets.back();
+    m_FreeAssets.pop_back();
+    m_Assets[index] = std::move(asset);
+    return index;
+}
+
+size_t AssetCache::FindContent(uint64_t hash, const std::vector<unsigned char>& bytes) const
+{
+    auto [begin, end] = m_ByContent.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        const auto& asset = m_Assets[it->second];
+        // the file is read again, only for the duplicates and the collisions
+        if (asset.ContentSize == bytes.size() && ReadFile(asset.Source) == bytes) return it->second;
+    }
+    return m_Assets.size();
+}
+
+std::string AssetCache::Key(std::string_view path)
+{
+    return std::filesystem::path{ path }.lexically_normal().generic_string();
+}
+
+void AssetCache::Request(std::string_view path)
+{
+    auto key = Key(path);
+    if (m_ByPath.contains(key) || std::find(m_Requested.begin(), m_Requested.end(), key) != m_Requested.end()) return;
+
+    m_Requested.push_back(std::move(key));
+}
+
+void AssetCache::LoadRequested(gfx::TextureStreamer* streamer)
+{
+    if (m_Requested.empty()) return;
+
+    std::vector<std::future<DecodedImage>> decoding;
+    std::vector<std::pair<std::string, const pack::Entry*>> baked;
+    for (auto& key : m_Requested) {
+        if (auto entry = m_Pack ? m_Pack->Find(key) : nullptr) {
+            baked.emplace_back(std::move(key), entry);
+            continue;
+        }
+        decoding.push_back(m_Pool.Submit([key = std::move(key)]() mutable { return Decode(std::move(key)); }));
+    }
+    m_Requested.clear();
+
+    // uploaded while the workers decode the rest
+    for (auto& [key, entry] : baked) {
+        m_ByPath[key] = AddAsset(Asset{
+            .Texture = m_Pack->LoadTexture(m_Textures, *entry),
+            .Source = {},
+            .ContentSize = 0,
+            .ContentHash = 0,
+            .Paths = 1,
+        });
+    }
+
+    for (auto& future : decoding) {
+        auto decoded = future.get();
+        if (!decoded.Image) {
+            std::cerr << "Could not load image " << decoded.Key << std::endl;
+            std::exit(37);
+        }
+
+        // every path holds its own reference, so unloading one keeps the texture of the others
+        if (auto same = FindContent(decoded.ContentHash, decoded.Bytes); same != m_Assets.size()) {
+            m_Textures.Acquire(m_Assets[same].Texture.Texture);
+            m_Assets[same].Paths++;
+            m_ByPath[decoded.Key] = same;
+            continue;
+        }
+
+        math::Vec2<float> size{ static_cast<float>(decoded.Image->Width), static_cast<float>(decoded.Image->Height) };
+        auto texture = m_Textures.Create();
+        if (streamer) {
+            streamer->Enqueue(texture, std::move(decoded.Image));
+        } else {
+            m_Textures.Allocate(texture, *decoded.Image);
+        }
+        auto index = AddAsset(Asset{
+            .Texture = TextureAsset{ texture, size },
+            .Source = decoded.Key,
+            .ContentSize = decoded.Bytes.size(),
+            .ContentHash = decoded.ContentHash,
+            .Paths = 1,
+        });
+        m_ByPath[decoded.Key] = index;
+        m_ByContent.emplace(decoded.ContentHash, index);
+    }
+}
+
+TextureAsset AssetCache::Texture(std::string_view path)
+{
+    auto key = Key(path);
+    if (!m_ByPath.contains(key)) {
+        Request(key);
+        LoadRequested();
+    }
+    return m_Assets[m_ByPath.at(key)].Texture;
+}
+
+void AssetCache::Unload(std::string_view path)
+{
+    auto it = m_ByPath.find(Key(path));
+    if (it == m_ByPath.end()) return;
+
+    auto index = it->second;
+    auto& asset = m_Assets[index];
+    m_Textures.Release(asset.Texture.Texture);
+    m_ByPath.erase(it);
+    if (--asset.Paths > 0) return;
+
+    // the last path of the slot, it is reused by the next asset
+    auto [begin, end] = m_ByContent.equal_range(asset.ContentHash);
+    for (auto content = begin; content != end; ++content) {
+        if (content->second == index) {
+            m_ByContent.erase(content);
+            break;
+        }
+    }
+    asset = Asset{};
+    m_FreeAssets.push_back(index);
+}
+
+gfx::Sprite AssetCache::Sprite(std::string_view path)
+{
+    auto asset = Texture(path);
+    return gfx::Sprite{ math::Bbox{ math::Vec2<float>{ 0.0f, 0.0f }, asset.Size }, asset.Texture };
+}
+
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/ThreadPool.h"
+#include "gfx/Sprite.h"
+#include "gfx/TextureRegistry.h"
+#include "gfx/TextureStreamer.h"
+#include "math/math.h"
+
+namespace fs
+{
+
+class AssetPack;
+
+struct TextureAsset {
+    gfx::TextureHandle Texture{ gfx::InvalidTexture };
+    math::Vec2<float> Size;
+};
+
+/* Loads every texture once: assets are deduplicated by path, and files with the same
+ * content (same hash, then same bytes) share the texture of the first one. Requested images are decoded in parallel
+ * on the pool, the uploads stay on the calling thread, the one owning the GL context.
+ * A mounted pack skips the decoding of the paths baked in it.
+ * The cache holds one reference on every texture it loaded; the handles it hands out borrow it,
+ * Acquire them on the registry to keep a texture past Unload. */
+class AssetCache {
+public:
+    AssetCache(core::ThreadPool& pool, gfx::TextureRegistry& textures)
+        : m_Pool{ pool },
+        m_Textures{ textures }
+    {
+    }
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    ~AssetCache();
+
+    /* Paths baked in pack are uploaded from it, no file is read or decoded for them.
+     * The pack must outlive the cache. */
+    void Mount(const AssetPack& pack) noexcept
+    {
+        m_Pack = &pack;
+    }
+
+    // queues path for the next LoadRequested, does nothing if it is already loaded or queued
+    void Request(std::string_view path);
+
+    /* Decodes the queued images on the pool and uploads them as they get ready.
+     * With a streamer the uploads are spread over the next frames instead,
+     * the textures are handed out at once and streamer.Ready tells when they can be shown. */
+    void LoadRequested(gfx::TextureStreamer* streamer = nullptr);
+
+    // loads path right away if it was not requested, uploaded at once, never streamed
+    TextureAsset Texture(std::string_view path);
+
+    // a sprite covering the texture at its size in pixels
+    gfx::Sprite Sprite(std::string_view path);
+
+    /* Drops the reference of the cache on the texture of path, the next Texture(path) loads it again.
+     * Paths sharing the texture keep it alive. */
+    void Unload(std::string_view path);
+
+    size_t Size() const noexcept
+    {
+        return m_ByPath.size();
+    }
+
+private:
+    struct Asset {
+        TextureAsset Texture;
+        std::string Source; // the file its content was read from, empty for a baked texture
+        size_t ContentSize{ 0 };
+        uint64_t ContentHash{ 0 };
+        size_t Paths{ 0 }; // the slot is free at 0
+    };
+
+    static std::string Key(std::string_view path);
+
+    // in a free slot when there is one, asset.Paths is 1
+    size_t AddAsset(Asset asset);
+    // the loaded asset with exactly these bytes, m_Assets.size() when there is none
+    size_t FindContent(uint64_t hash, const std::vector<unsigned char>& bytes) const;
+
+    core::ThreadPool& m_Pool;
+    gfx::TextureRegistry& m_Textures;
+    const AssetPack* m_Pack{ nullptr };
+    std::vector<std::string> m_Requested;
+    std::vector<Asset> m_Assets;
+    std::vector<size_t> m_FreeAssets;
+    std::unordered_map<std::string, size_t> m_ByPath; // into m_Assets
+    std::unordered_multimap<uint64_t, size_t> m_ByContent; // into m_Assets, collisions included
+};
+
+}
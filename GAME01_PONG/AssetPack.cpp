@@ -0,0 +1,230 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glad/glad.h>
+
+namespace fs
+{
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+    m_File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        m_File = nullptr;
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+        Close();
+        return false;
+    }
+
+    m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_Mapping) {
+        Close();
+        return false;
+    }
+
+    m_Data = static_cast<const std::byte*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    m_Size = static_cast<size_t>(size.QuadPart);
+    if (!m_Data) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close() noexcept
+{
+    if (m_Data) UnmapViewOfFile(m_Data);
+    if (m_Mapping) CloseHandle(m_Mapping);
+    if (m_File) CloseHandle(m_File);
+    m_Data = nullptr;
+    m_Mapping = nullptr;
+    m_File = nullptr;
+    m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const char* path)
+{
+    Close();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    // the mapping keeps the file alive, the descriptor is not needed anymore
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    m_Data = static_cast<const std::byte*>(data);
+    m_Size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close() noexcept
+{
+    if (m_Data) munmap(const_cast<std::byte*>(m_Data), m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+#endif
+
+static bool HasS3tc() noexcept
+{
+    static const bool supported = []() {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            auto name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) return true;
+        }
+        return false;
+    }();
+    return supported;
+}
+
+bool AssetPack::Open(const char* path)
+{
+    m_Index.clear();
+    if (!m_File.Open(path)) return false;
+
+    if (!Validate()) {
+        std::cerr << "Invalid asset pack " << path << std::endl;
+        m_File.Close();
+        return false;
+    }
+
+    const auto& header = *At<pack::Header>(0);
+    for (uint32_t i = 0; i < header.EntryCount; ++i) {
+        const auto* entry = At<pack::Entry>(header.EntriesOffset + i * sizeof(pack::Entry));
+        m_Index[std::string_view{ At<char>(entry->NameOffset), entry->NameLength }] = entry;
+    }
+    return true;
+}
+
+// number of levels down to 1x1, the largest mip count a texture of this size can have
+static uint32_t MipChainLength(uint32_t width, uint32_t height) noexcept
+{
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1) levels++;
+    return levels;
+}
+
+// everything the loader reads through the mapping must be inside the file, and the tables must be aligned for their type
+bool AssetPack::Validate() const noexcept
+{
+    auto inside = [size = m_File.Size()](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+
+    if (!inside(0, sizeof(pack::Header))) return false;
+    const auto& header = *At<pack::Header>(0);
+    if (header.Magic != pack::Magic || header.Version != pack::Version) return false;
+    if (!inside(header.EntriesOffset, uint64_t{ header.EntryCount } * sizeof(pack::Entry))) return false;
+    if (!inside(header.FramesOffset, uint64_t{ header.FrameCount } * sizeof(pack::Frame))) return false;
+    if (header.EntriesOffset % alignof(pack::Entry) != 0) return false;
+    if (header.FramesOffset % alignof(pack::Frame) != 0) return false;
+
+    for (uint32_t i = 0; i < header.EntryCount; ++i) {
+        const auto& entry = *At<pack::Entry>(header.EntriesOffset + i * sizeof(pack::Entry));
+        if (!inside(entry.NameOffset, entry.NameLength)) return false;
+        if (entry.Format >= pack::PixelFormat::Count) return false;
+        if (entry.Width == 0 || entry.Width > pack::MaxDimension) return false;
+        if (entry.Height == 0 || entry.Height > pack::MaxDimension) return false;
+        if (entry.MipCount == 0 || entry.MipCount > pack::MaxMips) return false;
+        if (entry.MipCount > MipChainLength(entry.Width, entry.Height)) return false;
+        if (entry.Alpha > static_cast<uint32_t>(gfx::AlphaClass::Translucent)) return false;
+        if (uint64_t{ entry.FirstFrame } + entry.FrameCount > header.FrameCount) return false;
+        for (uint32_t level = 0; level < entry.MipCount; ++level) {
+            // the driver reads as many bytes as the level has pixels, whatever the size says
+            uint32_t width = std::max(1u, entry.Width >> level);
+            uint32_t height = std::max(1u, entry.Height >> level);
+            if (entry.MipSizes[level] != pack::LevelSize(entry.Format, width, height)) return false;
+            if (!inside(entry.MipOffsets[level], entry.MipSizes[level])) return false;
+        }
+    }
+    return true;
+}
+
+const pack::Entry* AssetPack::Find(std::string_view name) const noexcept
+{
+    auto it = m_Index.find(name);
+    return it != m_Index.end() ? it->second : nullptr;
+}
+
+TextureAsset AssetPack::LoadTexture(gfx::TextureRegistry& textures, const pack::Entry& entry) const
+{
+    GLenum compressed_format = 0;
+    if (entry.Format == pack::PixelFormat::BC1) compressed_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    if (entry.Format == pack::PixelFormat::BC3) compressed_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    if (compressed_format && !HasS3tc()) {
+        std::cerr << "The driver cannot read the compressed texture "
+            << std::string_view{ At<char>(entry.NameOffset), entry.NameLength } << ", bake the pack without --bc" << std::endl;
+        std::exit(37);
+    }
+
+    std::vector<gfx::TextureLevel> levels;
+    for (uint32_t level = 0; level < entry.MipCount; ++level) {
+        levels.push_back({ At<std::byte>(entry.MipOffsets[level]), entry.MipSizes[level] });
+    }
+
+    auto texture = textures.Create();
+    textures.AllocateLevels(
+        texture, static_cast<int>(entry.Width), static_cast<int>(entry.Height),
+        compressed_format, levels, static_cast<gfx::AlphaClass>(entry.Alpha)
+    );
+    return TextureAsset{ texture, math::Vec2<float>{ static_cast<float>(entry.Width), static_cast<float>(entry.Height) } };
+}
+
+gfx::SpriteSheet AssetPack::LoadSpriteSheet(gfx::TextureRegistry& textures, const pack::Entry& entry) const
+{
+    if (entry.FrameCount == 0) {
+        std::cerr << "The texture " << std::string_view{ At<char>(entry.NameOffset), entry.NameLength } << " has no frames, it is not a sprite sheet" << std::endl;
+        std::exit(37);
+    }
+    auto asset = LoadTexture(textures, entry);
+    gfx::SpriteSheet sheet{ asset.Texture, asset.Size };
+
+    const auto& header = *At<pack::Header>(0);
+    for (uint32_t i = 0; i < entry.FrameCount; ++i) {
+        const auto& frame = *At<pack::Frame>(header.FramesOffset + (uint64_t{ entry.FirstFrame } + i) * sizeof(pack::Frame));
+        sheet.AddFrame(math::Bbox{ frame.X, frame.Y, frame.W, frame.H });
+    }
+    return sheet;
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+
+#include "AssetCache.h"
+#include "AssetPackFormat.h"
+#include "gfx/SpriteSheet.h"
+
+namespace fs
+{
+
+/* A read-only memory mapping of a whole file. */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close() noexcept;
+
+    const std::byte* Data() const noexcept { return m_Data; }
+    size_t Size() const noexcept { return m_Size; }
+
+private:
+    const std::byte* m_Data{ nullptr };
+    size_t m_Size{ 0 };
+#ifdef _WIN32
+    void* m_File{ nullptr };
+    void* m_Mapping{ nullptr };
+#endif
+};
+
+/* A pack baked by tools/AssetBaker. The file is mapped, nothing is decoded or copied:
+ * the mip levels go from the mapping to the driver. */
+class AssetPack {
+public:
+    // false if the file is missing or is not a valid pack
+    bool Open(const char* path);
+
+    // names are the paths given to the baker, like "Assets/ball.png"
+    const pack::Entry* Find(std::string_view name) const noexcept;
+
+    // a new texture of textures, the caller owns its reference
+    TextureAsset LoadTexture(gfx::TextureRegistry& textures, const pack::Entry& entry) const;
+
+    // the texture with the frames baked with it
+    gfx::SpriteSheet LoadSpriteSheet(gfx::TextureRegistry& textures, const pack::Entry& entry) const;
+
+    size_t Size() const noexcept
+    {
+        return m_Index.size();
+    }
+
+private:
+    bool Validate() const noexcept;
+
+    // offsets come from a validated pack: inside the file and aligned for T
+    template <typename T>
+    const T* At(uint64_t offset) const noexcept
+    {
+        return reinterpret_cast<const T*>(m_File.Data() + offset);
+    }
+
+    MappedFile m_File;
+    std::unordered_map<std::string_view, const pack::Entry*> m_Index;
+};
+
+}
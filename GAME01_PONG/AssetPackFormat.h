@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+namespace fs::pack
+{
+
+/* Layout of a baked asset pack, written by tools/AssetBaker and mapped read-only at runtime:
+ *
+ *   Header | Entry[EntryCount] | Frame[FrameCount] | names | pixel data
+ *
+ * Offsets are from the start of the file, every mip level starts on DataAlignment bytes
+ * so its pointer can go straight to glTexImage2D. All fields are little endian. */
+
+constexpr uint32_t Magic = 0x4b415047; // "GPAK"
+constexpr uint32_t Version = 1;
+constexpr uint32_t MaxMips = 16;
+constexpr uint64_t DataAlignment = 16;
+// the largest width or height a texture may have, the GL_MAX_TEXTURE_SIZE of common hardware
+constexpr uint32_t MaxDimension = 16384;
+
+enum class PixelFormat : uint32_t {
+    RGBA8,
+    BC1, // DXT1, opaque textures
+    BC3, // DXT5, textures with alpha
+    Count,
+};
+
+struct Header {
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t EntryCount;
+    uint32_t FrameCount;
+    uint64_t EntriesOffset;
+    uint64_t FramesOffset;
+    uint64_t NamesOffset;
+};
+
+// a texture and its mip chain, level 0 first
+struct Entry {
+    uint64_t NameOffset;
+    uint32_t NameLength;
+    PixelFormat Format;
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t MipCount;
+    uint32_t FirstFrame; // into the frame table
+    uint32_t FrameCount; // 0 when the texture is not an atlas
+    uint32_t Alpha; // gfx::AlphaClass
+    uint64_t MipOffsets[MaxMips];
+    uint32_t MipSizes[MaxMips];
+};
+
+// a pixel rect of an atlas
+struct Frame {
+    float X, Y, W, H;
+};
+
+static_assert(sizeof(Header) == 40);
+static_assert(sizeof(Entry) == 232);
+static_assert(sizeof(Frame) == 16);
+
+constexpr uint64_t AlignUp(uint64_t offset) noexcept
+{
+    return (offset + DataAlignment - 1) / DataAlignment * DataAlignment;
+}
+
+// bytes of one mip level of width x height
+constexpr uint32_t LevelSize(PixelFormat format, uint32_t width, uint32_t height) noexcept
+{
+    if (format == PixelFormat::RGBA8) return width * height * 4;
+
+    uint32_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == PixelFormat::BC1 ? 8 : 16);
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <charconv>
+#include <string_view>
+#include <vector>
+
+#include "math/math.h"
+
+namespace fs
+{
+
+/* Reads the pixel rects of a frame list in the JSON array or hash format exported by
+ * TexturePacker and Aseprite: every object under a "frame" key gives x, y, w and h. */
+inline std::vector<math::Bbox> ParseFrameList(std::string_view json)
+{
+    // 0 when the key, its ':' or its number is missing from the object; never reads past the object
+    auto read_number = [&json](size_t object_begin, size_t object_end, std::string_view key) {
+        auto key_position = json.find(key, object_begin);
+        if (key_position == std::string_view::npos || key_position > object_end) return 0.0f;
+        const char* begin = json.data() + key_position + key.size();
+        const char* end = json.data() + object_end;
+        auto skip_spaces = [end](const char* c) {
+            while (c < end && (*c == ' ' || *c == '\t' || *c == '\n' || *c == '\r')) ++c;
+            return c;
+        };
+        begin = skip_spaces(begin);
+        if (begin == end || *begin != ':') return 0.0f;
+        begin = skip_spaces(begin + 1);
+        float value = 0.0f;
+        if (std::from_chars(begin, end, value).ec != std::errc{}) return 0.0f;
+        return value;
+    };
+
+    std::vector<math::Bbox> frames;
+    for (auto position = json.find("\"frame\""); position != std::string_view::npos; position = json.find("\"frame\"", position + 1)) {
+        auto object_begin = json.find('{', position);
+        auto object_end = json.find('}', object_begin);
+        if (object_begin == std::string_view::npos || object_end == std::string_view::npos) break;
+
+        frames.push_back(math::Bbox{
+            read_number(object_begin, object_end, "\"x\""),
+            read_number(object_begin, object_end, "\"y\""),
+            read_number(object_begin, object_end, "\"w\""),
+            read_number(object_begin, object_end, "\"h\"")
+        });
+    }
+    return frames;
+}
+
+}
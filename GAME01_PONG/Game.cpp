@@ -1,11 +1,18 @@
 #include "Game.h"
 
-void Game::Load(fs::AssetLoader& loader)
+void Game::Load(fs::AssetCache& assets, gfx::Renderer<>& renderer, gfx::TextureStreamer* streamer)
 {
-    auto field = loader.LoadSpriteFromImage("Assets/field.png");
-    auto ball = loader.LoadSpriteFromImage("Assets/ball.png");
-    auto player1 = loader.LoadSpriteFromImage("Assets/paddle.png");
-    auto player2 = loader.LoadSpriteFromImage("Assets/paddle.png");
+    // decoded together, the paddles share one texture
+    for (auto path : { "Assets/field.png", "Assets/ball.png", "Assets/paddle.png" }) {
+        assets.Request(path);
+    }
+    assets.LoadRequested(streamer);
+    Streamer = streamer;
+
+    auto field = assets.Sprite("Assets/field.png");
+    auto ball = assets.Sprite("Assets/ball.png");
+    auto player1 = assets.Sprite("Assets/paddle.png");
+    auto player2 = assets.Sprite("Assets/paddle.png");
 
     Sprites.push_back(ball);
     Sprites.push_back(player1);
@@ -20,6 +27,10 @@ void Game::Load(fs::AssetLoader& loader)
     NameToId["player1"] = 1;
     NameToId["player2"] = 2;
     NameToId["field"] = 3;
+
+    // the field never moves, it is uploaded once and drawn by the renderer in every state
+    BackgroundLayer = renderer.CreateLayer(1);
+    renderer.Layer(BackgroundLayer).Add(Sprites[NameToId["field"]]);
     ResetPositions();
 }
 
@@ -38,6 +49,8 @@ void Game::Update()
 
 void Game::Draw(gfx::Renderer<>& renderer)
 {
+    // the field layer draws by itself, it stays hidden until its texture is complete
+    renderer.Layer(BackgroundLayer).SetVisible(Ready(GetSprite("field")));
     CurrentState->Draw(*this, renderer);
 }
 
@@ -83,6 +96,11 @@ const gfx::Sprite& Game::GetSprite(const char* name)
     return Sprites[id];
 }
 
+bool Game::Ready(const gfx::Sprite& sprite) const
+{
+    return !Streamer || Streamer->Ready(sprite.Texture);
+}
+
 
 math::Vec2<float> Game::GetVelocity(const char* name)
 {
@@ -21,6 +21,8 @@ struct Game {
     std::vector<gfx::Sprite> Sprites;
     core::multivector<math::Vec2<float>, math::Vec2<float>, math::Vec2<float>> Entities{ EntityCount };
     std::unordered_map<const char*, int> NameToId;
+    gfx::Renderer<>::LayerId BackgroundLayer = 0;
+    const gfx::TextureStreamer* Streamer = nullptr;
     int Player1Score = 0, Player2Score = 0;
     bool ShouldQuit = false;
 
@@ -34,13 +36,15 @@ struct Game {
     }
 
     void Reset();
-    void Load(fs::AssetLoader& loader);
+    // with a streamer the textures upload over the next frames, sprites are drawn once theirs is Ready
+    void Load(fs::AssetCache& assets, gfx::Renderer<>& renderer, gfx::TextureStreamer* streamer = nullptr);
     void HandleInput(glfw::Window& window);
     void Update();
     void Draw(gfx::Renderer<>& renderer);
 
     void ResetPositions();
     const gfx::Sprite& GetSprite(const char* name);
+    bool Ready(const gfx::Sprite& sprite) const;
     math::Bbox GetBbox(const char* name);
     math::Vec2<float> GetVelocity(const char* name);
     void SetVelocity(const char* name, math::Vec2<float> v);
@@ -5,11 +5,6 @@ void StartState::Exit(Game& game)
     game.Reset();
 }
 
-void StartState::Draw(Game& game, gfx::Renderer<>& renderer)
-{
-    renderer.DrawSprite(game.Sprites[game.NameToId["field"]]);
-}
-
 void StartState::HandleInput(Game& game, glfw::Window& window)
 {
     if (window.GetKey(GLFW_KEY_SPACE) == GLFW_PRESS) {
@@ -28,8 +23,8 @@ void PlayState::Update(Game& game)
 
 void PlayState::Draw(Game& game, gfx::Renderer<>& renderer)
 {
-    for (ptrdiff_t i = game.NameToId["field"]; i >= 0; --i) {
-        renderer.DrawSprite(game.Sprites[i]);
+    for (ptrdiff_t i = game.NameToId["field"] - 1; i >= 0; --i) {
+        if (game.Ready(game.Sprites[i])) renderer.DrawSprite(game.Sprites[i]);
     }
 }
 
@@ -61,11 +56,6 @@ void PlayerWonState::Exit(Game& game)
     game.Reset();
 }
 
-void PlayerWonState::Draw(Game& game, gfx::Renderer<>& renderer)
-{
-    renderer.DrawSprite(game.Sprites[game.NameToId["field"]]);
-}
-
 void PlayerWonState::HandleInput(Game& game, glfw::Window& window)
 {
     if (window.GetKey(GLFW_KEY_SPACE) == GLFW_PRESS) {
@@ -75,8 +65,8 @@ void PlayerWonState::HandleInput(Game& game, glfw::Window& window)
 
 void PauseState::Draw(Game& game, gfx::Renderer<>& renderer)
 {
-    for (ptrdiff_t i = game.NameToId["field"]; i >= 0; --i) {
-        renderer.DrawSprite(game.Sprites[i]);
+    for (ptrdiff_t i = game.NameToId["field"] - 1; i >= 0; --i) {
+        if (game.Ready(game.Sprites[i])) renderer.DrawSprite(game.Sprites[i]);
     }
 }
 
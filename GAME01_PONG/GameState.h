@@ -17,7 +17,6 @@ public:
 class StartState : public IGameState {
 public:
     void Exit(Game& game) override;
-    void Draw(Game& game, gfx::Renderer<>& renderer) override;
     void HandleInput(Game& game, glfw::Window& window) override;
 };
 
@@ -31,7 +30,6 @@ public:
 class PlayerWonState : public IGameState {
 public:
     void Exit(Game& game) override;
-    void Draw(Game& game, gfx::Renderer<>& renderer) override;
     void HandleInput(Game& game, glfw::Window& window) override;
 
 };
@@ -0,0 +1,80 @@
+#include "HeadlessPlatform.h"
+
+#ifdef PLATFORM_HEADLESS
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+
+egl::Context::Context(int major, int minor)
+{
+    // the surfaceless platform needs no GPU device nor display server
+    auto client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (client_extensions && std::strstr(client_extensions, "EGL_MESA_platform_surfaceless") && get_platform_display) {
+        m_Display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (m_Display == EGL_NO_DISPLAY) {
+        m_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (m_Display == EGL_NO_DISPLAY || !eglInitialize(m_Display, nullptr, nullptr)) {
+        throw Error("Could not initialize an EGL display");
+    }
+
+    auto extensions = eglQueryString(m_Display, EGL_EXTENSIONS);
+    if (!extensions || !std::strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        eglTerminate(m_Display);
+        throw Error("The EGL display cannot make a context current without a surface");
+    }
+
+    // no surface type: the default asks for window surfaces, a surfaceless display has none
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(m_Display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        eglTerminate(m_Display);
+        throw Error("No EGL config renders with desktop OpenGL");
+    }
+
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    m_Context = eglCreateContext(m_Display, config, EGL_NO_CONTEXT, context_attributes);
+    if (m_Context == EGL_NO_CONTEXT || !eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, m_Context)) {
+        if (m_Context != EGL_NO_CONTEXT) eglDestroyContext(m_Display, m_Context);
+        eglTerminate(m_Display);
+        throw Error("Could not create a surfaceless OpenGL context");
+    }
+
+    glad::InitGLLoader((glad::LoadProc)eglGetProcAddress);
+}
+
+egl::Context::~Context()
+{
+    eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(m_Display, m_Context);
+    eglTerminate(m_Display);
+}
+
+HeadlessPlatform::HeadlessPlatform(int width, int height, const char* name)
+    : egl::Context{ 3, 3 },
+    PlatformServices{ name, width, height }
+{
+    // there is no default framebuffer to present to
+    Renderer.SetPresent(false);
+}
+
+void HeadlessPlatform::EndDrawing()
+{
+    Renderer.Flush();
+    CaptureFrame(&Renderer.Target());
+}
+
+#endif
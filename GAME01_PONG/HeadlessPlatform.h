@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Platform.h"
+
+/* The platform without a display: a surfaceless EGL context (Mesa llvmpipe, or any GPU driver
+ * with EGL_KHR_surfaceless_context) and a renderer that draws into its offscreen target.
+ * For benchmarks, golden images and server-side replays on machines without a display server.
+ * Only built with PLATFORM_HEADLESS defined, which needs the EGL headers and -lEGL:
+ *
+ *   c++ -DPLATFORM_HEADLESS ... -lEGL
+ *
+ * For a software context:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 PONG --headless */
+#ifdef PLATFORM_HEADLESS
+
+#include <EGL/egl.h>
+
+namespace egl
+{
+
+class Error : public std::runtime_error {
+public:
+    explicit Error(const char* message) noexcept
+        : std::runtime_error{ message }
+    {
+    }
+    const char* what() const noexcept
+    {
+        return std::runtime_error::what();
+    }
+};
+
+/* A GL core context current on this thread with no surface at all, glad is loaded from it.
+ * The display is the surfaceless platform when the client has it, else the default display. */
+class Context {
+public:
+    Context(int major, int minor);
+    ~Context();
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+private:
+    EGLDisplay m_Display{ EGL_NO_DISPLAY };
+    EGLContext m_Context{ EGL_NO_CONTEXT };
+};
+
+}
+
+// the context is the first base, current before the services are built
+class HeadlessPlatform : private egl::Context, public PlatformServices {
+public:
+    HeadlessPlatform(int width, int height, const char* name);
+    void EndDrawing();
+};
+
+#endif
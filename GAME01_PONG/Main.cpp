@@ -1,19 +1,102 @@
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <cstdlib>
 #include <chrono>
 #include <cassert>
 #include <unordered_map>
+#include <string_view>
 #include <thread>
 #include "Game.h"
+#include "HeadlessPlatform.h"
 
 static Game game{};
 
-int main()
+#ifdef PLATFORM_HEADLESS
+/* No window and no input: the match plays itself for frames frames, as fast as the context renders them. */
+static int RunHeadless(int frames, const char* capture)
+{
+    auto platform = std::make_shared<HeadlessPlatform>((int)game.WindowWidth, (int)game.WindowHeight, "PONG");
+    if (capture) {
+        platform->StartCapture(capture);
+        // nothing is on screen, the run may wait for the encoder instead of dropping frames
+        platform->Capture->SetOffline(true);
+    }
+    game.Load(platform->Assets, platform->Renderer, &platform->Streamer);
+    // the serve StartState would do on the space bar
+    game.Reset();
+    game.ChangeState<PlayState>();
+    platform->Renderer.SetColor(0);
+    platform->Renderer.EnableGpuTiming(true);
+
+    // the GPU timings arrive a few frames late, each is summed once
+    gfx::GpuTimings gpu{};
+    size_t gpu_frames = 0;
+    double sort_ms = 0.0, convert_ms = 0.0, submit_ms = 0.0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < frames && !game.ShouldQuit; ++frame) {
+        game.Update();
+        platform->BeginDrawing();
+        game.Draw(platform->Renderer);
+        platform->EndDrawing();
+
+        const auto& stats = platform->Renderer.Stats();
+        sort_ms += stats.SortMs;
+        convert_ms += stats.ConvertMs;
+        submit_ms += stats.SubmitMs;
+        if (stats.Gpu.Frame > gpu.Frame) {
+            gpu.Frame = stats.Gpu.Frame;
+            gpu.ClearMs += stats.Gpu.ClearMs;
+            gpu.UploadMs += stats.Gpu.UploadMs;
+            gpu.DrawMs += stats.Gpu.DrawMs;
+            gpu.TotalMs += stats.Gpu.TotalMs;
+            gpu_frames++;
+        }
+    }
+    glFinish();
+    auto seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << frames << " frames in " << seconds << " s, " << seconds * 1000.0 / frames << " ms per frame" << std::endl;
+    std::cout << "CPU ms per frame: sort " << sort_ms / frames << ", convert " << convert_ms / frames << ", submit " << submit_ms / frames << std::endl;
+    if (gpu_frames) {
+        std::cout << "GPU ms per frame over " << gpu_frames << " frames: clear " << gpu.ClearMs / gpu_frames << ", upload " << gpu.UploadMs / gpu_frames
+            << ", draw " << gpu.DrawMs / gpu_frames << ", total " << gpu.TotalMs / gpu_frames << std::endl;
+    }
+    if (platform->Capture) {
+        std::cout << platform->Capture->Captured() << " frames captured, " << platform->Capture->Dropped() << " dropped" << std::endl;
+    }
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv)
 {
     std::ios::sync_with_stdio(false);
+    // PONG [--headless [frames]] [--capture <directory or .y4m file>]
+    bool headless = false;
+    int frames = 600;
+    const char* capture = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{ argv[i] };
+        if (arg == "--headless") {
+            headless = true;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0) frames = std::atoi(argv[++i]);
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capture = argv[++i];
+        }
+    }
+
+    if (headless) {
+#ifdef PLATFORM_HEADLESS
+        return RunHeadless(frames, capture);
+#else
+        std::cerr << "built without EGL, there is no headless platform" << std::endl;
+        return 1;
+#endif
+    }
+
     auto platform = std::make_shared<Platform>((int)game.WindowWidth, (int)game.WindowHeight, "PONG");
-    game.Load(platform->Loader);
+    if (capture) platform->StartCapture(capture);
+    game.Load(platform->Assets, platform->Renderer, &platform->Streamer);
     game.ChangeState<StartState>();
     platform->Renderer.SetColor(0);
 
@@ -30,6 +113,8 @@ int main()
         platform->BeginDrawing();
         game.Draw(platform->Renderer);
         platform->EndDrawing();
+        // feeds Renderer::EnableAdaptiveResolution, pong is light enough to never enable it
+        platform->Renderer.ReportFrameTime(std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count());
 
         std::this_thread::sleep_until(frame_end - std::chrono::microseconds(1000));
         while (std::chrono::high_resolution_clock::now() < frame_end)
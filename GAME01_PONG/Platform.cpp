@@ -1,17 +1,30 @@
 #include "Platform.h"
+#include "FrameList.h"
 
 #include <iostream>
 #include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 
 
+static glad::LoadProc s_LoadProc = nullptr;
+
 void glad::InitGLLoader(glad::LoadProc load_proc)
 {
     if (!gladLoadGLLoader(load_proc)) {
         throw Error("Failed to initialize GLAD");
     }
+    s_LoadProc = load_proc;
+}
+
+glad::LoadProc glad::GetLoadProc() noexcept
+{
+    return s_LoadProc;
 }
 
 namespace fs
@@ -36,17 +49,51 @@ gfx::Sprite AssetLoader::LoadSpriteFromImage(const char* sprite_path) const noex
 {
     auto image = LoadImage(sprite_path);
     std::cout << "loaded image " << sprite_path << ": " << image.Width << "x" << image.Height << std::endl;
-    gfx::Texture texture{};
-    texture.Allocate(image);
+    auto texture = m_Textures.Create();
+    m_Textures.Allocate(texture, image);
     std::cout << "Allocated texture\n";
     return gfx::Sprite{
         math::Bbox{0.0f, 0.0f, (float)image.Width, (float)image.Height},
         texture
     };
 }
+
+gfx::SpriteSheet AssetLoader::LoadSpriteSheet(const char* image_path, int frame_width, int frame_height) const noexcept
+{
+    auto sprite = LoadSpriteFromImage(image_path);
+    gfx::SpriteSheet sheet{ sprite.Texture, sprite.Bbox.Size };
+    if (!sheet.SliceGrid(frame_width, frame_height)) {
+        std::cerr << "No " << frame_width << "x" << frame_height << " frame fits in " << image_path << std::endl;
+        std::exit(37);
+    }
+    return sheet;
 }
 
-Platform::Platform(int width, int height, const char* name)
+gfx::SpriteSheet AssetLoader::LoadSpriteSheet(const char* image_path, const char* frames_path) const noexcept
+{
+    std::ifstream file{ frames_path };
+    if (!file) {
+        std::cerr << "Could not load frame list " << frames_path << std::endl;
+        std::exit(37);
+    }
+    std::stringstream json;
+    json << file.rdbuf();
+
+    auto sprite = LoadSpriteFromImage(image_path);
+    gfx::SpriteSheet sheet{ sprite.Texture, sprite.Bbox.Size };
+    for (const auto& frame : ParseFrameList(json.str())) {
+        sheet.AddFrame(frame);
+    }
+    if (sheet.FrameCount() == 0) {
+        std::cerr << "No frames in frame list " << frames_path << std::endl;
+        std::exit(37);
+    }
+    std::cout << "loaded " << sheet.FrameCount() << " frames from " << frames_path << std::endl;
+    return sheet;
+}
+}
+
+PlatformWindow::PlatformWindow(int width, int height, const char* name)
     : m_GLFWHandle{ glfw::Init() },
     m_WindowHints{
         glfw::WindowHints{
@@ -54,22 +101,41 @@ Platform::Platform(int width, int height, const char* name)
             .ContextVersionMajor = 3,
             .ContextVersionMinor = 3
         }.Apply() },
-    Window{ width, height, name },
-    Renderer{ Window },
-    Loader{}
+    Window{ width, height, name }
 {
-
-    Renderer.Init();
 }
 
-void Platform::BeginDrawing()
+void PlatformServices::BeginDrawing()
 {
+    Streamer.Update();
     Renderer.Clear();
 }
 
+void PlatformServices::StartCapture(const std::filesystem::path& output)
+{
+    // the view follows the window, or is the offscreen target without one
+    auto size = Renderer.View().Size;
+    Capture = std::make_unique<gfx::FrameCapture>(output, gfx::FrameCapture::FormatOf(output), static_cast<int>(size.x()), static_cast<int>(size.y()));
+}
+
+void PlatformServices::CaptureFrame(const gfx::RenderTarget* source)
+{
+    if (!Capture) return;
+    auto size = Renderer.View().Size;
+    Capture->Capture(static_cast<int>(size.x()), static_cast<int>(size.y()), source);
+}
+
+Platform::Platform(int width, int height, const char* name)
+    : PlatformWindow{ width, height, name },
+    PlatformServices{ name, Window }
+{
+}
+
 void Platform::EndDrawing()
 {
     Renderer.Flush();
+    // the frame is on the back buffer, offscreen ones included, until the swap
+    CaptureFrame(nullptr);
     Window.SwapBuffers();
     glfw::PollEvents();
 }
\ No newline at end of file
@@ -24,6 +24,9 @@ public:
 
 using LoadProc = GLADloadproc;
 void InitGLLoader(LoadProc load_proc);
+
+// the loader given to InitGLLoader, for the entry points past GL 3.3 that glad does not load
+LoadProc GetLoadProc() noexcept;
 }
 
 namespace glfw
@@ -305,6 +308,9 @@ struct Library {
 
 
 #include "gfx/gfx.h"
+#include "core/ThreadPool.h"
+#include "AssetCache.h"
+#include "AssetPack.h"
 #include <iostream>
 #include <cstdlib>
 
@@ -314,22 +320,75 @@ class AssetLoader {
 public:
 
 public:
-    AssetLoader() {}
+    explicit AssetLoader(gfx::TextureRegistry& textures)
+        : m_Textures{ textures }
+    {
+    }
     gfx::Image LoadImage(const char* path) const noexcept;
     gfx::Sprite LoadSpriteFromImage(const char* sprite_path) const noexcept;
+    gfx::SpriteSheet LoadSpriteSheet(const char* image_path, int frame_width, int frame_height) const noexcept;
+    gfx::SpriteSheet LoadSpriteSheet(const char* image_path, const char* frames_path) const noexcept;
+private:
+    gfx::TextureRegistry& m_Textures;
 };
 
 }
 
-class Platform {
+/* What every platform sets up once its GL context is current: the renderer, the asset pipeline,
+ * the texture streamer and the capture. A platform derives from it after the base holding its context,
+ * base classes are built in order. */
+class PlatformServices {
+public:
+    // renderer_args are the arguments of the gfx::Renderer constructor before the texture registry
+    template <typename... RendererArgs>
+    PlatformServices(const char* name, RendererArgs&&... renderer_args)
+        : Textures{},
+        Renderer{ std::forward<RendererArgs>(renderer_args)..., Textures },
+        Loader{ Textures },
+        Workers{},
+        Pack{},
+        Assets{ Workers, Textures },
+        Streamer{ Textures }
+    {
+        // baked by tools/AssetBaker, the loose files are used without it
+        if (Pack.Open("Assets/assets.pack")) {
+            Assets.Mount(Pack);
+        }
+
+        Renderer.Init(gfx::ShaderCache::DefaultDirectory(name));
+        // declared after the renderer, it is set once both exist
+        Renderer.SetWorkers(&Workers);
+    }
+
+    void BeginDrawing();
+    // every frame from now on goes to output, see gfx::FrameCapture::FormatOf
+    void StartCapture(const std::filesystem::path& output);
+
+    gfx::TextureRegistry Textures;
+    gfx::Renderer<> Renderer;
+    fs::AssetLoader Loader;
+    core::ThreadPool Workers;
+    fs::AssetPack Pack;
+    fs::AssetCache Assets;
+    gfx::TextureStreamer Streamer;
+    std::unique_ptr<gfx::FrameCapture> Capture;
+
+protected:
+    // after the flush, source as in gfx::FrameCapture::Capture
+    void CaptureFrame(const gfx::RenderTarget* source);
+};
+
+class PlatformWindow {
 private:
     glfw::Library m_GLFWHandle;
     glfw::WindowHints m_WindowHints;
+public:
+    PlatformWindow(int width, int height, const char* name);
+    glfw::Window Window;
+};
+
+class Platform : public PlatformWindow, public PlatformServices {
 public:
     Platform(int width, int height, const char* name);
-    void BeginDrawing();
     void EndDrawing();
-    glfw::Window Window;
-    gfx::Renderer<256> Renderer;
-    fs::AssetLoader Loader;
 };
\ No newline at end of file
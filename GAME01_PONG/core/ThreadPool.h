@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace core
+{
+
+/* A fixed set of worker threads taking jobs from a single queue.
+ * Submit returns a future, so results (and exceptions) come back to the caller. */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = DefaultThreadCount())
+    {
+        for (size_t i = 0; i < std::max<size_t>(thread_count, 1); ++i) {
+            m_Threads.emplace_back([this]() { Work(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock{ m_Mutex };
+            m_Stopping = true;
+        }
+        m_Wakeup.notify_all();
+        for (auto& thread : m_Threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename F>
+    auto Submit(F&& job) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        // std::function needs a copyable target, the task is not
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+        auto future = task->get_future();
+        {
+            std::lock_guard lock{ m_Mutex };
+            m_Jobs.emplace([task]() { (*task)(); });
+        }
+        m_Wakeup.notify_one();
+        return future;
+    }
+
+    size_t Size() const noexcept
+    {
+        return m_Threads.size();
+    }
+
+    // leaves a core to the thread submitting the jobs
+    static size_t DefaultThreadCount() noexcept
+    {
+        auto cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 1;
+    }
+
+private:
+    void Work()
+    {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock{ m_Mutex };
+                m_Wakeup.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+                if (m_Jobs.empty()) return;
+
+                job = std::move(m_Jobs.front());
+                m_Jobs.pop();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> m_Threads;
+    std::queue<std::function<void()>> m_Jobs;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wakeup;
+    bool m_Stopping{ false };
+};
+
+} // core
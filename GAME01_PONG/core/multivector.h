@@ -3,6 +3,7 @@
 #include <iostream>
 #include <type_traits>
 #include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -114,6 +115,25 @@ public:
         swap_elements_impl(i, j, std::index_sequence_for<Types...>{});
     }
 
+    /* Removes the elements for which pred returns true, keeping the order of the others.
+     * Returns the number of removed elements. */
+    template <typename Predicate>
+    size_t erase_if(Predicate pred)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            if (pred(std::as_const(*this)[i])) continue;
+            if (kept != i) {
+                move_element_impl(i, kept, std::index_sequence_for<Types...>{});
+            }
+            kept++;
+        }
+
+        size_t removed = size() - kept;
+        truncate_impl(kept, std::index_sequence_for<Types...>{});
+        return removed;
+    }
+
     template <typename Compare = std::less<>>
     void sort(Compare comp = std::less{})
     {
@@ -175,6 +195,18 @@ private:
         return (std::swap(std::get<Is>(m_storage)[i], std::get<Is>(m_storage)[j]), ...);
     }
 
+    template <size_t ...Is>
+    constexpr void move_element_impl(size_t from, size_t to, std::index_sequence<Is...>)
+    {
+        ((std::get<Is>(m_storage)[to] = std::move(std::get<Is>(m_storage)[from])), ...);
+    }
+
+    template <size_t ...Is>
+    constexpr void truncate_impl(size_t count, std::index_sequence<Is...>)
+    {
+        (std::get<Is>(m_storage).erase(std::get<Is>(m_storage).begin() + count, std::get<Is>(m_storage).end()), ...);
+    }
+
     template <size_t ...Is>
     constexpr auto resize_impl(size_t capacity, std::index_sequence<Is...>)
     {
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "../core/multivector.h"
+
+namespace gfx
+{
+
+using AnimationHandle = uint32_t;
+constexpr AnimationHandle InvalidAnimation = UINT32_MAX;
+
+/* A run of consecutive frames of a sprite sheet. */
+struct AnimationClip {
+    uint32_t FirstFrame{ 0 };
+    uint32_t FrameCount{ 1 };
+    float FramesPerSecond{ 12.0f };
+    bool Loop{ true };
+};
+
+/* Advances many animations at once. The state is kept in columns (frame index, timer, rate...)
+ * so Update is a tight loop over arrays instead of a virtual call per animated object.
+ * Clips without frames are rejected, Update would wrap the frames around a count of 0.
+ * A removed animation keeps its slot, stopped, until Play reuses it: handles stay small and dense. */
+class Animator {
+public:
+    // InvalidAnimation for a clip without frames
+    AnimationHandle Play(const AnimationClip& clip)
+    {
+        if (clip.FrameCount == 0) return InvalidAnimation;
+        if (!m_FreeHandles.empty()) {
+            auto handle = m_FreeHandles.back();
+            m_FreeHandles.pop_back();
+            SetClip(handle, clip);
+            return handle;
+        }
+        m_Animations.push_back(clip.FirstFrame, clip.FrameCount, 0u, 0.0f, clip.FramesPerSecond, static_cast<uint8_t>(clip.Loop));
+        return static_cast<AnimationHandle>(m_Animations.size() - 1);
+    }
+
+    // the handle is invalid afterwards, a later Play may return it again
+    void Remove(AnimationHandle handle)
+    {
+        if (std::find(m_FreeHandles.begin(), m_FreeHandles.end(), handle) != m_FreeHandles.end()) return;
+        // a single frame at rate 0: Update leaves it alone
+        m_Animations[handle] = std::make_tuple(0u, 1u, 0u, 0.0f, 0.0f, uint8_t{ 0 });
+        m_FreeHandles.push_back(handle);
+    }
+
+    // restarts the animation with another clip, the handle stays valid; false and nothing changes for a clip without frames
+    bool SetClip(AnimationHandle handle, const AnimationClip& clip)
+    {
+        if (clip.FrameCount == 0) return false;
+        m_Animations[handle] = std::make_tuple(clip.FirstFrame, clip.FrameCount, 0u, 0.0f, clip.FramesPerSecond, static_cast<uint8_t>(clip.Loop));
+        return true;
+    }
+
+    void Update(float dt) noexcept
+    {
+        const auto& counts = m_Animations.get<1>();
+        auto& frames = m_Animations.get<2>();
+        auto& timers = m_Animations.get<3>();
+        const auto& rates = m_Animations.get<4>();
+        const auto& loops = m_Animations.get<5>();
+
+        for (size_t i = 0; i < m_Animations.size(); ++i) {
+            timers[i] += dt * rates[i];
+            float steps = std::floor(timers[i]);
+            timers[i] -= steps;
+
+            uint32_t frame = frames[i] + static_cast<uint32_t>(steps);
+            frames[i] = loops[i] ? frame % counts[i] : std::min(frame, counts[i] - 1);
+        }
+    }
+
+    // the frame of the sprite sheet to show
+    constexpr uint32_t Frame(AnimationHandle handle) const noexcept
+    {
+        return m_Animations.get<0>()[handle] + m_Animations.get<2>()[handle];
+    }
+
+    constexpr bool Finished(AnimationHandle handle) const noexcept
+    {
+        return !m_Animations.get<5>()[handle] && m_Animations.get<2>()[handle] + 1 == m_Animations.get<1>()[handle];
+    }
+
+    // the animations playing, the removed ones are not counted
+    constexpr size_t Size() const noexcept
+    {
+        return m_Animations.size() - m_FreeHandles.size();
+    }
+
+private:
+    // first frame, frame count, current frame, timer (in frames), frames per second, loop
+    core::multivector<uint32_t, uint32_t, uint32_t, float, float, uint8_t> m_Animations;
+    std::vector<AnimationHandle> m_FreeHandles;
+};
+
+}
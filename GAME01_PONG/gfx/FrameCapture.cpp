@@ -0,0 +1,223 @@
+#include "FrameCapture.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace gfx
+{
+
+FrameCapture::FrameCapture(const std::filesystem::path& output, Format format, int width, int height, int fps)
+    : m_Output{ output },
+    m_Format{ format },
+    m_Width{ width },
+    m_Height{ height },
+    m_FrameBytes{ static_cast<size_t>(width) * static_cast<size_t>(height) * 4 },
+    m_Slots(SlotCount)
+{
+    if (m_Format == Format::Png) {
+        std::filesystem::create_directories(m_Output);
+    } else {
+        m_Video.open(m_Output, std::ios::binary);
+        if (!m_Video) {
+            throw std::runtime_error("Could not create " + m_Output.string());
+        }
+        m_Video << "YUV4MPEG2 W" << m_Width << " H" << m_Height << " F" << fps << ":1 Ip A1:1 C444\n";
+    }
+
+    for (auto& slot : m_Slots) {
+        slot.Buffer.Bind();
+        slot.Buffer.Allocate(m_FrameBytes, GpuBuffer::Usage::StreamRead);
+    }
+    m_Slots.back().Buffer.Unbind();
+}
+
+FrameCapture::~FrameCapture()
+{
+    Retire(true);
+    for (auto& encoding : m_Encoding) {
+        encoding.get();
+    }
+    // the frames dropped at the end
+    while (m_Format == Format::Y4m && m_VideoFrames > 0 && m_VideoFrames < m_NextFrame) {
+        WriteVideoFrame();
+    }
+}
+
+void FrameCapture::Capture(int width, int height, const RenderTarget* source)
+{
+    if (width != m_Width || height != m_Height) {
+        Resize(width, height);
+    }
+    if (m_Stopped) return;
+    Retire(false);
+
+    size_t frame = m_NextFrame++;
+    auto& slot = m_Slots[m_NextSlot];
+    if (slot.Fence) {
+        // the copy of SlotCount frames ago is still running, waiting for it would stall this frame
+        if (!m_Offline) {
+            m_Dropped++;
+            return;
+        }
+        Retire(true);
+    }
+
+    if (source) {
+        source->BindRead();
+    } else {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+    }
+    slot.Buffer.Bind();
+    // into the buffer: the call returns at once and the copy happens when the GPU gets there
+    glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    slot.Buffer.Unbind();
+    slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.Frame = frame;
+    m_NextSlot = (m_NextSlot + 1) % SlotCount;
+}
+
+void FrameCapture::Resize(int width, int height)
+{
+    if (m_Stopped) return;
+    // the copies in flight have the old size, they are encoded before the buffers go
+    Retire(true);
+    if (m_Format == Format::Y4m) {
+        std::cerr << "Capture to " << m_Output.string() << " stopped at frame " << m_NextFrame
+            << ": the video is " << m_Width << "x" << m_Height << ", the frames are now " << width << "x" << height << std::endl;
+        m_Stopped = true;
+        return;
+    }
+
+    m_Width = width;
+    m_Height = height;
+    m_FrameBytes = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+    for (auto& slot : m_Slots) {
+        slot.Buffer.Bind();
+        slot.Buffer.Allocate(m_FrameBytes, GpuBuffer::Usage::StreamRead);
+    }
+    m_Slots.back().Buffer.Unbind();
+}
+
+FrameCapture::Format FrameCapture::FormatOf(const std::filesystem::path& output) noexcept
+{
+    return output.extension() == ".y4m" ? Format::Y4m : Format::Png;
+}
+
+void FrameCapture::Retire(bool wait)
+{
+    // from the oldest copy, the GPU finishes them in order
+    for (size_t i = 0; i < SlotCount; ++i) {
+        auto& slot = m_Slots[(m_NextSlot + i) % SlotCount];
+        if (!slot.Fence) continue;
+
+        GLuint64 timeout = wait ? std::chrono::nanoseconds{ std::chrono::seconds{ 1 } }.count() : 0;
+        GLenum status = glClientWaitSync(slot.Fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+        if (status == GL_TIMEOUT_EXPIRED && !wait) break;
+        glDeleteSync(slot.Fence);
+        slot.Fence = nullptr;
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+            m_Dropped++;
+            continue;
+        }
+
+        slot.Buffer.Bind();
+        auto* mapped = static_cast<const uint8_t*>(slot.Buffer.Map(0, m_FrameBytes, GL_MAP_READ_BIT));
+        if (!mapped) {
+            slot.Buffer.Unbind();
+            m_Dropped++;
+            continue;
+        }
+        // GL rows go bottom up, the files top down
+        std::vector<uint8_t> pixels(m_FrameBytes);
+        const size_t row_bytes = static_cast<size_t>(m_Width) * 4;
+        for (int row = 0; row < m_Height; ++row) {
+            std::memcpy(pixels.data() + row * row_bytes, mapped + (m_Height - 1 - row) * row_bytes, row_bytes);
+        }
+        slot.Buffer.Unmap();
+        slot.Buffer.Unbind();
+
+        if (!wait) {
+            while (!m_Encoding.empty() && m_Encoding.front().wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready) {
+                m_Encoding.front().get();
+                m_Encoding.pop_front();
+            }
+            if (m_Encoding.size() >= MaxEncoding) {
+                if (!m_Offline) {
+                    m_Dropped++;
+                    continue;
+                }
+                // offline, the oldest frame is waited for to keep the queue bounded
+                m_Encoding.front().get();
+                m_Encoding.pop_front();
+            }
+        }
+        Encode(slot.Frame, std::move(pixels));
+    }
+}
+
+void FrameCapture::Encode(size_t frame, std::vector<uint8_t> pixels)
+{
+    m_Captured++;
+    // the size may change before the encoder gets to the frame
+    m_Encoding.push_back(m_Encoder.Submit([this, frame, width = m_Width, height = m_Height, pixels = std::move(pixels)]() {
+        if (m_Format == Format::Png) {
+            WritePng(frame, width, height, pixels);
+        } else {
+            WriteY4m(frame, pixels);
+        }
+    }));
+}
+
+void FrameCapture::WritePng(size_t frame, int width, int height, const std::vector<uint8_t>& pixels) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06zu.png", frame);
+    auto path = (m_Output / name).string();
+    if (!stbi_write_png(path.c_str(), width, height, 4, pixels.data(), width * 4)) {
+        std::cerr << "Could not write " << path << std::endl;
+    }
+}
+
+// BT.601 studio range, the default of Y4M readers
+void FrameCapture::WriteY4m(size_t frame, const std::vector<uint8_t>& pixels)
+{
+    // the frames dropped since the previous one show it again
+    while (m_VideoFrames > 0 && m_VideoFrames < frame) {
+        WriteVideoFrame();
+    }
+
+    const size_t count = static_cast<size_t>(m_Width) * static_cast<size_t>(m_Height);
+    m_Planes.resize(count * 3);
+    uint8_t* y = m_Planes.data();
+    uint8_t* cb = y + count;
+    uint8_t* cr = cb + count;
+    for (size_t i = 0; i < count; ++i) {
+        int r = pixels[4 * i];
+        int g = pixels[4 * i + 1];
+        int b = pixels[4 * i + 2];
+        y[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        cb[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        cr[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    // the first frame also stands for the ones dropped before it
+    while (m_VideoFrames <= frame) {
+        WriteVideoFrame();
+    }
+}
+
+void FrameCapture::WriteVideoFrame()
+{
+    m_Video << "FRAME\n";
+    m_Video.write(reinterpret_cast<const char*>(m_Planes.data()), static_cast<std::streamsize>(m_Planes.size()));
+    m_VideoFrames++;
+}
+
+} // gfx
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../core/ThreadPool.h"
+#include "GpuBuffer.h"
+#include "RenderTarget.h"
+
+namespace gfx
+{
+
+/* Records frames to disk without stalling the frame that produced them.
+ * Capture starts an asynchronous glReadPixels into a ring of pixel pack buffers,
+ * the buffer is mapped SlotCount frames later, once its fence says the copy is done,
+ * and the pixels go to an encoder thread: one PNG per frame in a directory, or a single Y4M video.
+ * When the GPU or the encoder fall behind, frames are dropped instead of waited for;
+ * the video repeats the previous frame in their place, so it keeps the timing of the game.
+ * An offline capture, with nobody watching the frames, waits instead and drops none.
+ * A resize reallocates the ring, except for a video: its size is in its header, it stops there. */
+class FrameCapture {
+public:
+    enum class Format {
+        Png, // output is a directory, frame_000000.png onwards
+        Y4m, // output is one file, 4:4:4 YCbCr at fps
+    };
+
+    constexpr static size_t SlotCount = 3;
+    // frames read back but not encoded yet, past this the new ones are dropped
+    constexpr static size_t MaxEncoding = 8;
+
+    // throws std::runtime_error when the output cannot be created
+    FrameCapture(const std::filesystem::path& output, Format format, int width, int height, int fps = 60);
+    // waits for the frames in flight and encodes them
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    /* After the frame is drawn, before it is presented: reads width x height pixels from source,
+     * or from the back buffer of the default framebuffer when source is nullptr. */
+    void Capture(int width, int height, const RenderTarget* source = nullptr);
+
+    /* Offline, Capture waits for the copies and the encoder instead of dropping frames:
+     * for headless runs, which are not paced by a display and outrun any encoder. */
+    void SetOffline(bool offline) noexcept { m_Offline = offline; }
+
+    // Y4m when the output ends with .y4m, Png otherwise
+    static Format FormatOf(const std::filesystem::path& output) noexcept;
+
+    constexpr size_t Captured() const noexcept { return m_Captured; }
+    constexpr size_t Dropped() const noexcept { return m_Dropped; }
+    // a video stops at the first resize
+    constexpr bool Stopped() const noexcept { return m_Stopped; }
+
+private:
+    struct PixelBuffer {
+        GpuBuffer Buffer{ GpuBuffer::Target::PixelPackBuffer };
+        GLsync Fence{ nullptr };
+        size_t Frame{ 0 };
+    };
+
+    // hands the finished readbacks to the encoder, with wait only at destruction
+    void Retire(bool wait);
+    void Resize(int width, int height);
+    void Encode(size_t frame, std::vector<uint8_t> pixels);
+    void WritePng(size_t frame, int width, int height, const std::vector<uint8_t>& pixels) const;
+    void WriteY4m(size_t frame, const std::vector<uint8_t>& pixels);
+    // m_Planes once more
+    void WriteVideoFrame();
+
+    std::filesystem::path m_Output;
+    Format m_Format;
+    int m_Width;
+    int m_Height;
+    size_t m_FrameBytes;
+    std::vector<PixelBuffer> m_Slots;
+    size_t m_NextSlot{ 0 };
+    size_t m_Captured{ 0 };
+    size_t m_Dropped{ 0 };
+    size_t m_NextFrame{ 0 };
+    bool m_Stopped{ false };
+    bool m_Offline{ false };
+    std::ofstream m_Video;
+    // encoder thread only: the last frame written and the count of frames in the video
+    std::vector<uint8_t> m_Planes;
+    size_t m_VideoFrames{ 0 };
+    std::deque<std::future<void>> m_Encoding;
+    // one thread, so the frames are encoded in order; last, it finishes its jobs before the rest goes
+    core::ThreadPool m_Encoder{ 1 };
+};
+
+} // gfx
@@ -23,9 +23,24 @@ void GpuBuffer::Unbind() const noexcept
     glBindBuffer(static_cast<GLenum>(m_Target), 0);
 }
 
+void GpuBuffer::BindBase(GLuint index) const noexcept
+{
+    glBindBufferBase(static_cast<GLenum>(m_Target), index, m_Id);
+}
+
 void GpuBuffer::Allocate(size_t capacity_bytes, Usage usage) const noexcept
 {
     glBufferData(static_cast<GLenum>(m_Target), capacity_bytes, nullptr, static_cast<GLenum>(usage));
 }
 
+void* GpuBuffer::Map(size_t offset, size_t length, GLbitfield access) const noexcept
+{
+    return glMapBufferRange(static_cast<GLenum>(m_Target), static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(length), access);
+}
+
+bool GpuBuffer::Unmap() const noexcept
+{
+    return glUnmapBuffer(static_cast<GLenum>(m_Target)) == GL_TRUE;
+}
+
 } // gfx
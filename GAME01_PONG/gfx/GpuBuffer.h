@@ -38,9 +38,14 @@ public:
     ~GpuBuffer();
     void Bind() const noexcept;
     void Unbind() const noexcept;
+    void BindBase(GLuint index) const noexcept;
 
     void Allocate(size_t capacity_bytes, Usage usage) const noexcept;
 
+    // expects the buffer to be bound, returns nullptr on failure
+    void* Map(size_t offset, size_t length, GLbitfield access) const noexcept;
+    bool Unmap() const noexcept;
+
     template <typename T>
     void SetData(T* data, size_t element_count, size_t offset = 0) const noexcept
     {
@@ -3,25 +3,66 @@
 
 #include <iostream>
 #include <algorithm>
+#include <chrono>
+#include <future>
+#include <span>
 #include <vector>
+#include "../core/ThreadPool.h"
 #include "SpriteStorage.h"
 #include "RenderCommandQueue.h"
+#include "VertexFormat.h"
+#include "VertexWriter.h"
 
 namespace gfx
 {
 
-template <size_t MaxSprites>
+/* Converts the sprites in vertex data of VertexFormat and draw commands.
+ * The output is split in batches of at most BatchSprites sprites, one per upload of the GPU buffer,
+ * so the number of sprites per frame is not bounded by the size of the buffer.
+ * A batch never mixes render passes, the executor changes the blending state between batches.
+ * Buckets share material and texture, a batch may hold several materials: programs change between commands.
+ * Positions are written relative to origin, formats with small integer positions need it near the sprites. */
+template <size_t BatchSprites, typename VertexFormat = StandardVertexFormat>
 class GpuDataConverter {
 public:
-    constexpr static size_t VertexCount = MaxSprites * SpriteStorage<MaxSprites>::FloatsPerSprite();
-    GpuDataConverter(SpriteStorage<MaxSprites>& sprites)
+    using Vertex = typename VertexFormat::Vertex;
+    constexpr static size_t VerticesPerSprite = VertexFormat::VerticesPerSprite;
+
+    /* Fixed, from measurements: a vertex costs about 12 ns per sprite to write, a task about 5 us to submit and wait for.
+     * A slice of MinSpritesPerTask spends about a tenth of its time on the task, a frame needs two slices
+     * for one to be written off the calling thread; smaller frames are converted on the calling thread. */
+    constexpr static size_t MinSpritesPerTask = 4096;
+    constexpr static size_t ParallelThreshold = 2 * MinSpritesPerTask;
+
+    /* With a pool, big frames are split in slices of sprites, one per worker and one for the calling thread:
+     * each slice writes its vertices and the commands of the buckets starting in it, the commands are then merged in order. */
+    GpuDataConverter(SpriteStorage<BatchSprites>& sprites, math::Vec2<float> origin = {}, core::ThreadPool* pool = nullptr)
+        : m_Origin{ origin }
     {
         if (sprites.Size() == 0) return;
-        Convert(sprites);
+        m_RenderData.resize(sprites.Size() * VerticesPerSprite);
+        Convert(sprites, pool);
     }
 
-    std::array<float, VertexCount> VertexData() noexcept { return m_RenderData; }
-    RenderCommandQueue DrawingData() noexcept { return m_DrawingData; }
+    std::span<const Vertex> VertexData(size_t batch) const noexcept
+    {
+        size_t begin = m_BatchStarts[batch] * VerticesPerSprite;
+        size_t end = batch + 1 < m_BatchStarts.size() ? m_BatchStarts[batch + 1] * VerticesPerSprite : m_RenderData.size();
+        return std::span<const Vertex>{ m_RenderData.data() + begin, end - begin };
+    }
+
+    constexpr math::Vec2<float> Origin() const noexcept { return m_Origin; }
+
+    const RenderCommandQueue& DrawingData() const noexcept { return m_DrawingData; }
+
+    // the slices the frame was split in, one of them converted by the calling thread; 0 without a split
+    constexpr size_t Tasks() const noexcept { return m_Tasks; }
+
+    // runs of sprites sharing pass, material and texture, before the splits at the batch ends
+    constexpr size_t Buckets() const noexcept { return m_Buckets; }
+
+    // the part of the conversion spent sorting the sprites
+    constexpr double SortMs() const noexcept { return m_SortMs; }
 
 private:
     struct DataBucket {
@@ -29,15 +70,51 @@ private:
         size_t Length;
     };
 
-    void Convert(SpriteStorage<MaxSprites>& sprites) noexcept
+    void Convert(SpriteStorage<BatchSprites>& sprites, core::ThreadPool* pool)
     {
         auto buckets = GroupData(sprites);
-        ProcessBuckets(buckets, sprites);
+        LayoutBatches(sprites);
+        if (!pool || sprites.Size() < ParallelThreshold) {
+            BuildCommands(buckets, 0, buckets.size(), sprites, m_DrawingData);
+            PushTexturedRects(0, sprites, 0, sprites.Size());
+            return;
+        }
+
+        // sorted sprite i always lands at i * VerticesPerSprite and the batch of a sprite is known, so the slices need no prefix sum
+        size_t tasks = std::min(pool->Size() + 1, sprites.Size() / MinSpritesPerTask);
+        size_t per_task = (sprites.Size() + tasks - 1) / tasks;
+        auto first_bucket = [&buckets](size_t sprite) {
+            return static_cast<size_t>(std::partition_point(buckets.begin(), buckets.end(), [sprite](const DataBucket& bucket) {
+                return bucket.Start < sprite;
+            }) - buckets.begin());
+        };
+
+        std::vector<RenderCommandQueue> fragments((sprites.Size() - 1) / per_task);
+        std::vector<std::future<void>> slices;
+        for (size_t slice = 0; slice < fragments.size(); ++slice) {
+            size_t begin = (slice + 1) * per_task;
+            size_t end = std::min(begin + per_task, sprites.Size());
+            slices.push_back(pool->Submit([this, &buckets, &sprites, &fragments, &first_bucket, slice, begin, end]() {
+                BuildCommands(buckets, first_bucket(begin), first_bucket(end), sprites, fragments[slice]);
+                PushTexturedRects(begin * VerticesPerSprite, sprites, begin, end);
+            }));
+        }
+        m_Tasks = slices.size() + 1;
+
+        // the first slice is the calling thread's, its commands go straight in the queue
+        BuildCommands(buckets, 0, first_bucket(per_task), sprites, m_DrawingData);
+        PushTexturedRects(0, sprites, 0, std::min(per_task, sprites.Size()));
+        for (size_t slice = 0; slice < slices.size(); ++slice) {
+            slices[slice].get();
+            m_DrawingData.Append(fragments[slice]);
+        }
     }
 
-    std::vector<DataBucket> GroupData(SpriteStorage<MaxSprites>& sprites)
+    std::vector<DataBucket> GroupData(SpriteStorage<BatchSprites>& sprites)
     {
+        auto sort_start = std::chrono::steady_clock::now();
         sprites.Sort();
+        m_SortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sort_start).count();
 
         std::vector<DataBucket> buckets{};
         size_t bucket_beginning = 0;
@@ -55,79 +132,80 @@ private:
         }
 
         buckets.push_back({ bucket_beginning, bucket_length + 1 });
+        m_Buckets = buckets.size();
 
         return buckets;
     }
 
-    void ProcessBuckets(const std::vector<DataBucket>& buckets, SpriteStorage<MaxSprites>& sprites)
+    /* A batch never mixes passes and the sorted sprites keep each pass contiguous:
+     * a batch starts at the first sprite of every pass and every BatchSprites sprites after it. */
+    void LayoutBatches(const SpriteStorage<BatchSprites>& sprites)
     {
-        //for (const auto& bucket : buckets) {
-        //    std::cout << "bucket" << bucket.Start << ", " << bucket.Length << std::endl;
-        //}
-        int render_data_offset = 0;
-        for (const auto& bucket : buckets) {
+        for (size_t begin = 0; begin < sprites.Size();) {
+            auto pass = sprites.Pass(begin);
+            size_t low = begin + 1;
+            size_t high = sprites.Size();
+            while (low < high) {
+                size_t middle = low + (high - low) / 2;
+                if (sprites.Pass(middle) == pass) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+
+            for (size_t start = begin; start < low; start += BatchSprites) {
+                m_BatchStarts.push_back(start);
+            }
+            begin = low;
+        }
+    }
+
+    // the commands of buckets [first, last) in queue, batches are numbered for the whole frame
+    void BuildCommands(const std::vector<DataBucket>& buckets, size_t first, size_t last, const SpriteStorage<BatchSprites>& sprites, RenderCommandQueue& queue) const
+    {
+        for (size_t i = first; i < last; ++i) {
+            const auto& bucket = buckets[i];
             auto type = sprites.Type(bucket.Start);
             GLenum mode;
             if (type == SpriteType::TexturedRect) {
-                mode = GL_TRIANGLE_STRIP;
+                mode = VertexFormat::Mode;
             }
 
             auto texture = sprites.Texture(bucket.Start);
-            auto draw_count = static_cast<GLsizei>(bucket.Length);
-
-            std::vector<int> firsts;
-            std::vector<GLsizei> counts(bucket.Length, (GLsizei)SpriteStorage<MaxSprites>::VerticesPerSprite());
-            for (size_t i = bucket.Start; i < bucket.Start + bucket.Length; ++i) {
-                firsts.push_back(static_cast<int>(i) * static_cast<int>(SpriteStorage<MaxSprites>::VerticesPerSprite()));
-                //std::cout << "command" << i << "first " << firsts.back() << std::endl;
-                if (sprites.Type(i) == gfx::SpriteType::TexturedRect) {
-                    render_data_offset = PushInterleavedTexturedRect(render_data_offset, sprites.Bbox(i), sprites.Depth(i));
-                }
+            auto material = sprites.Material(bucket.Start);
+            auto pass = sprites.Pass(bucket.Start);
+
+            // a bucket that crosses the end of a batch is split in one command per batch
+            size_t batch = static_cast<size_t>(std::upper_bound(m_BatchStarts.begin(), m_BatchStarts.end(), bucket.Start) - m_BatchStarts.begin()) - 1;
+            size_t bucket_end = bucket.Start + bucket.Length;
+            for (size_t start = bucket.Start; start < bucket_end; ++batch) {
+                size_t batch_start = m_BatchStarts[batch];
+                size_t end = std::min(bucket_end, batch_start + BatchSprites);
+
+                // the sprites of a bucket are contiguous in the batch: a single run, a single glDrawElements
+                std::vector<int> firsts{ static_cast<int>(start - batch_start) };
+                std::vector<GLsizei> counts{ static_cast<GLsizei>(end - start) };
+                queue.Push(RenderCommand{ texture, mode, std::move(firsts), std::move(counts), 1, batch, pass, material });
+                start = end;
             }
-            m_DrawingData.Push(RenderCommand{ texture, mode, firsts, counts, draw_count });
         }
-
-        //for (int i = 0; i < render_data_offset; ++i) {
-        //    std::cout << m_RenderData[i] << " ";
-        //    if (i % 3 == 2) std::cout << std::endl;
-        //}
-        //exit(0);
     }
 
-    constexpr int PushInterleavedTexturedRect(int current_offset, math::Bbox bbox, float depth)
+    // straight from the columns, vectorized for the formats that have a VertexWriter; textured rects are the only sprite type
+    size_t PushTexturedRects(size_t current_offset, const SpriteStorage<BatchSprites>& sprites, size_t begin, size_t end)
     {
-        // top-left
-        m_RenderData[current_offset++] = bbox.Pos.x();
-        m_RenderData[current_offset++] = bbox.Pos.y();
-        m_RenderData[current_offset++] = depth;
-        m_RenderData[current_offset++] = 0.0f;
-        m_RenderData[current_offset++] = 0.0f;
-
-        // bottom-left
-        m_RenderData[current_offset++] = bbox.Pos.x();
-        m_RenderData[current_offset++] = bbox.Pos.y() + bbox.Size.y();
-        m_RenderData[current_offset++] = depth;
-        m_RenderData[current_offset++] = 0.0f;
-        m_RenderData[current_offset++] = 1.0f;
-
-        // top-right
-        m_RenderData[current_offset++] = bbox.Pos.x() + bbox.Size.x();
-        m_RenderData[current_offset++] = bbox.Pos.y();
-        m_RenderData[current_offset++] = depth;
-        m_RenderData[current_offset++] = 1.0f;
-        m_RenderData[current_offset++] = 0.0f;
-
-        // bottom-right
-        m_RenderData[current_offset++] = bbox.Pos.x() + bbox.Size.x();
-        m_RenderData[current_offset++] = bbox.Pos.y() + bbox.Size.y();
-        m_RenderData[current_offset++] = depth;
-        m_RenderData[current_offset++] = 1.0f;
-        m_RenderData[current_offset++] = 1.0f;
-
-        return current_offset;
+        auto* out = m_RenderData.data() + current_offset;
+        auto* written = VertexWriter<VertexFormat>::WriteRects(out, sprites.Columns(), begin, end, m_Origin);
+        return current_offset + static_cast<size_t>(written - out);
     }
 
-    std::array<float, VertexCount> m_RenderData;
+    math::Vec2<float> m_Origin;
+    std::vector<Vertex> m_RenderData;
+    std::vector<size_t> m_BatchStarts;
+    size_t m_Tasks{ 0 };
+    size_t m_Buckets{ 0 };
+    double m_SortMs{ 0.0 };
     RenderCommandQueue m_DrawingData;
 };
 
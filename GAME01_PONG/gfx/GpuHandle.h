@@ -2,6 +2,9 @@
 
 #include <array>
 #include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <cstdlib>
 #include <iostream>
@@ -11,9 +14,15 @@
 #include "../math/math.h"
 
 #include "GpuBuffer.h"
+#include "GpuTimer.h"
+#include "QuadIndexBuffer.h"
 #include "Shader.h"
+#include "ShaderCache.h"
+#include "ShaderRegistry.h"
+#include "UniformBuffer.h"
 #include "VertexArray.h"
 #include "RenderCommandQueue.h"
+#include "TextureRegistry.h"
 
 
 namespace gfx
@@ -22,117 +31,252 @@ namespace gfx
 /* Manages GPU and loads data into it */
 class GpuHandle {
 public:
-    GpuHandle(size_t capacity) :
+    constexpr static GLuint FrameBlockBinding = 0;
+
+    GpuHandle(size_t capacity, const TextureRegistry& textures) :
+        m_Textures{ textures },
         m_Size{ 0 },
         m_Capacity{ capacity },
         m_VertexArray{},
         m_VertexBuffer{ gfx::GpuBuffer::Target::ArrayBuffer },
-        m_Projection{}
+        m_FrameUniforms{ FrameBlockBinding },
+        m_FrameData{}
     {
         std::cout << "enabling depth test\n";
         glEnable(GL_DEPTH_TEST);
         glDepthFunc(GL_LESS);
-        glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
-    ShaderId CreateShader(const char* vertex_shader_source, const char* fragment_shader_source)
+    /* Adds a program to the registry, the first one created is the default material.
+     * With a cache the program is linked from its stored binary when there is one. */
+    MaterialId CreateShader(
+        const char* vertex_shader_source,
+        const char* fragment_shader_source,
+        ShaderCache* cache = nullptr,
+        std::span<const std::string_view> defines = {},
+        const char* geometry_shader_source = nullptr)
+    {
+        // building a program leaves it in use
+        m_BoundProgram = InvalidMaterial;
+        return m_Shaders.Create(
+            vertex_shader_source, fragment_shader_source, geometry_shader_source ? geometry_shader_source : "",
+            defines, cache, FrameBlockBinding
+        );
+    }
+
+    constexpr const ShaderRegistry& Shaders() const noexcept
     {
-        // one day can generalize for multiple shaders, now its just one.
-        m_ShaderProgram = ShaderProgram{ vertex_shader_source, fragment_shader_source };
-        if (!m_ShaderProgram.Build()) return -1;
-        return m_ShaderProgram.Id();
+        return m_Shaders;
     }
 
+    // the layout of the streaming buffer is the one of VertexFormat
+    template <typename VertexFormat>
     void Allocate()
     {
         m_VertexBuffer.Bind();
         m_VertexBuffer.Allocate(m_Capacity, gfx::GpuBuffer::Usage::DynamicDraw);
 
-        m_VertexArray.Bind();
-        m_VertexArray.SetAttribute(0, 3, GL_FLOAT, 5 * sizeof(float), 0);
-        m_VertexArray.SetAttribute(1, 2, GL_FLOAT, 5 * sizeof(float), 3 * sizeof(float));
-        m_VertexArray.Unbind();
+        VertexFormat::SetLayout(m_VertexArray);
         m_VertexBuffer.Unbind();
+
+        if constexpr (VertexFormat::Mode == GL_TRIANGLES) {
+            m_Quads.Allocate(m_Capacity / (sizeof(typename VertexFormat::Vertex) * VertexFormat::VerticesPerSprite));
+            m_UploadedBytes += m_Quads.SizeBytes();
+        }
+        m_FrameUniforms.Allocate();
     }
 
-    template <size_t N>
-    bool UploadVertexData(const std::array<float, N>& data)
+    /* Replaces the content of the vertex buffer with one batch of data.
+     * The storage is orphaned first, so a batch never waits for the draws of the previous one. */
+    template <typename Vertex>
+    bool UploadVertexData(std::span<const Vertex> data)
     {
-        if (m_Size >= m_Capacity) {
+        if (data.size_bytes() > m_Capacity) {
             return false;
         }
 
-        //for (int i = 0; i < data.size(); ++i) {
-        //    std::cout << data[i] << " ";
-        //    if (i % 5 == 4) std::cout << std::endl;
-        //}
-        //exit(0);
-
-        // migt need bind unbind va
         m_VertexBuffer.Bind();
-        m_VertexBuffer.SetData(data, m_Size);
+        m_VertexBuffer.Allocate(m_Capacity, gfx::GpuBuffer::Usage::DynamicDraw);
+        m_VertexBuffer.SetData(data.data(), data.size());
         m_VertexBuffer.Unbind();
-        m_Size += data.size();
+        m_Size = data.size_bytes();
+        m_UploadedBytes += data.size_bytes();
+        m_Timer.Mark(GpuSection::Upload);
         return true;
     }
 
     constexpr void SetProjectionMatrix(const math::Mat<float, 4, 4>& proj)
     {
-        m_Projection = proj;
+        m_FrameData.Projection = proj;
     }
 
     constexpr void SetProjectionMatrix(math::Mat<float, 4, 4>&& proj)
     {
-        m_Projection = std::move(proj);
+        m_FrameData.Projection = std::move(proj);
+    }
+
+    constexpr void SetCamera(math::Vec2<float> camera) noexcept
+    {
+        m_FrameData.Camera = camera;
     }
 
-    void UploadCommandData(const RenderCommandQueue& queue)
+    constexpr void SetTime(float time) noexcept
     {
-        m_ShaderProgram.Use();
-        m_ShaderProgram["projection"] = m_Projection;
+        m_FrameData.Time = time;
+    }
 
+    /* Opaque pass: no blending, cutout texels are discarded and depth is written.
+     * Translucent pass: blending, fully transparent texels are discarded and depth is only tested.
+     * The alpha cutoff is set on every program as it gets used. */
+    void SetPass(RenderPass pass)
+    {
+        m_Pass = pass;
+        if (pass == RenderPass::Opaque) {
+            glDisable(GL_BLEND);
+            glDepthMask(GL_TRUE);
+        } else {
+            glEnable(GL_BLEND);
+            glDepthMask(GL_FALSE);
+        }
+    }
 
-        for (size_t i = 0; i < queue.Size(); ++i) {
-            //auto shader_id = queue.Shader(i);
-            //auto shader_program = shaders[shader_id];
-            const auto& tex = queue.Texture(i);
-            auto parameters = queue.Parameters(i);
+    void UploadFrameData()
+    {
+        m_FrameUniforms.Upload(m_FrameData);
+        m_UploadedBytes += sizeof(FrameData);
+    }
+
+    void UploadCommandData(const RenderCommandQueue& queue, math::Vec2<float> origin = {})
+    {
+        UploadCommandData(queue, 0, queue.Size(), origin);
+    }
+
+    void UploadCommandData(const RenderCommandQueue& queue, size_t begin, size_t end, math::Vec2<float> origin = {})
+    {
+        ExecuteCommands(m_VertexArray, queue, begin, end, origin);
+    }
+
+    /* Draws commands whose vertices live in a buffer other than the streaming one, like the retained layers.
+     * origin is the batch origin of the vertex positions, only the compact formats read it.
+     * The program stays bound from one call to the next until Free, the layers and the batches of a frame
+     * only switch at a material boundary. Nothing else may use a program in between. */
+    void ExecuteCommands(const VertexArray& vertex_array, const RenderCommandQueue& queue, size_t begin, size_t end, math::Vec2<float> origin = {})
+    {
+        vertex_array.Bind();
+        m_Quads.Bind();
+
+        // commands come sorted by material then texture, the program and the texture only change at the boundaries
+        TextureHandle bound_texture = InvalidTexture;
+        bool texture_bound = false;
+        for (size_t i = begin; i < end; ++i) {
+            auto material = m_Shaders.Resolve(queue.Material(i));
+            if (material != m_BoundProgram) {
+                m_BoundProgram = material;
+                m_Shaders.Use(material);
+                m_ProgramSwitches++;
+                m_UniformsSet = false;
+            }
+            // the same program across a pass or a batch origin only gets new uniforms
+            if (!m_UniformsSet || m_UniformsPass != m_Pass || m_UniformsOrigin != origin) {
+                m_Shaders.SetAlphaCutoff(material, m_Pass == RenderPass::Opaque ? 0.5f : 1.0f / 255.0f);
+                m_Shaders.SetBatchOrigin(material, origin);
+                m_UniformsSet = true;
+                m_UniformsPass = m_Pass;
+                m_UniformsOrigin = origin;
+            }
 
-            m_VertexBuffer.Bind();
-            m_VertexArray.Bind();
-            tex.Bind();
-            m_ShaderProgram["tex"] = 0;
+            auto parameters = queue.Parameters(i);
 
-            glMultiDrawArrays(parameters.Mode, parameters.First, parameters.Count, parameters.DrawCount);
-            tex.Unbind();
-            m_VertexArray.Unbind();
-            m_VertexBuffer.Unbind();
+            if (!texture_bound || queue.Texture(i) != bound_texture) {
+                bound_texture = queue.Texture(i);
+                texture_bound = true;
+                m_Textures.Bind(bound_texture);
+                m_TextureBinds++;
+            }
+            // one vertex per sprite, the runs are ranges of points
+            if (parameters.Mode == GL_POINTS) {
+                glMultiDrawArrays(GL_POINTS, parameters.First, parameters.Count, parameters.DrawCount);
+            } else if (parameters.DrawCount == 1) {
+                m_Quads.Draw(static_cast<size_t>(parameters.First[0]), static_cast<size_t>(parameters.Count[0]));
+            } else {
+                m_Quads.MultiDraw(parameters.IndexCounts, parameters.BaseVertices, parameters.DrawCount);
+            }
+            m_Timer.MarkCommand();
         }
-        // exit(1);
+
+        if (texture_bound) TextureRegistry::Unbind();
+        vertex_array.Unbind();
     }
 
     constexpr void Clear(const math::Color& color) noexcept
     {
+        // the translucent pass of the previous frame leaves depth writes off
+        glDepthMask(GL_TRUE);
         glClearColor(color.r(), color.g(), color.b(), color.a());
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        m_Timer.Mark(GpuSection::Clear);
     }
 
+    // ends the frame: the program is used again at the first command of the next one, whoever used another in between
     constexpr void Free() noexcept
     {
         // free the gpu linear allocator :D
 
         m_Size = 0;
+        m_BoundProgram = InvalidMaterial;
+        m_UniformsSet = false;
+    }
+
+    // glUseProgram calls since the last call, for the stats
+    constexpr size_t TakeProgramSwitches() noexcept
+    {
+        return std::exchange(m_ProgramSwitches, 0);
+    }
+
+    constexpr size_t TakeTextureBinds() noexcept
+    {
+        return std::exchange(m_TextureBinds, 0);
+    }
+
+    // buffer data of the renderer's own buffers: vertices, quad indices and frame uniforms
+    constexpr size_t TakeUploadedBytes() noexcept
+    {
+        return std::exchange(m_UploadedBytes, 0);
+    }
+
+    // marks the clear, the uploads and every command once enabled, see GpuTimer
+    constexpr GpuTimer& Timer() noexcept
+    {
+        return m_Timer;
+    }
+
+    constexpr const GpuTimer& Timer() const noexcept
+    {
+        return m_Timer;
     }
 private:
+    const TextureRegistry& m_Textures;
     size_t m_Capacity;
     size_t m_Size;
 
     gfx::VertexArray m_VertexArray;
     gfx::GpuBuffer m_VertexBuffer;
-    gfx::ShaderProgram m_ShaderProgram;
+    QuadIndexBuffer m_Quads;
+    ShaderRegistry m_Shaders;
+    RenderPass m_Pass{ RenderPass::Opaque };
+    // the program in use and the uniforms it was given, kept across ExecuteCommands until Free
+    MaterialId m_BoundProgram{ InvalidMaterial };
+    bool m_UniformsSet{ false };
+    RenderPass m_UniformsPass{ RenderPass::Opaque };
+    math::Vec2<float> m_UniformsOrigin;
+    size_t m_ProgramSwitches{ 0 };
+    size_t m_TextureBinds{ 0 };
+    size_t m_UploadedBytes{ 0 };
+    GpuTimer m_Timer;
 
-    math::Mat<float, 4, 4> m_Projection;
+    UniformBuffer<FrameData> m_FrameUniforms;
+    FrameData m_FrameData;
 };
 
 } // gfx
@@ -0,0 +1,131 @@
+#include "GpuTimer.h"
+
+namespace gfx
+{
+
+GpuTimer::~GpuTimer()
+{
+    for (auto& set : m_Sets) {
+        if (!set.Queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(set.Queries.size()), set.Queries.data());
+        }
+    }
+}
+
+void GpuTimer::SetEnabled(bool enabled) noexcept
+{
+    m_Enabled = enabled;
+    if (!enabled) {
+        // the sets in flight are not read anymore, their queries are simply written again later
+        m_Recording = false;
+        for (auto& set : m_Sets) {
+            set.Pending = false;
+        }
+    }
+}
+
+void GpuTimer::BeginFrame()
+{
+    if (!m_Enabled) return;
+    if (!m_Checked) {
+        GLint bits = 0;
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        m_Supported = bits > 0;
+        m_Checked = true;
+    }
+    if (!m_Supported) return;
+
+    // from the oldest set, the GPU reaches them in order
+    for (size_t i = 0; i < FrameCount; ++i) {
+        auto& set = m_Sets[(m_Current + i) % FrameCount];
+        if (set.Pending && !Collect(set)) break;
+    }
+
+    auto& set = m_Sets[m_Current];
+    if (set.Pending) {
+        set.Pending = false;
+        m_Dropped++;
+    }
+    if (set.Queries.empty()) {
+        set.Queries.resize(InitialMarks);
+        glGenQueries(static_cast<GLsizei>(InitialMarks), set.Queries.data());
+    }
+    set.Labels.clear();
+    set.Commands = 0;
+    set.Frame = ++m_Frame;
+    m_Recording = true;
+    glQueryCounter(set.Queries[0], GL_TIMESTAMP);
+}
+
+void GpuTimer::Mark(GpuSection section)
+{
+    Write(section, NotACommand);
+}
+
+void GpuTimer::MarkCommand()
+{
+    if (!m_Recording) return;
+    Write(GpuSection::Draw, m_Sets[m_Current].Commands++);
+}
+
+void GpuTimer::EndFrame()
+{
+    if (!m_Recording) return;
+    Write(GpuSection::Other, NotACommand);
+    m_Sets[m_Current].Pending = true;
+    m_Current = (m_Current + 1) % FrameCount;
+    m_Recording = false;
+}
+
+void GpuTimer::Write(GpuSection section, uint32_t command)
+{
+    if (!m_Recording) return;
+    auto& set = m_Sets[m_Current];
+    size_t query = set.Labels.size() + 1;
+    if (query == set.Queries.size()) {
+        // the new queries are only written from now on, the ones in flight keep their names
+        set.Queries.resize(query * 2);
+        glGenQueries(static_cast<GLsizei>(query), set.Queries.data() + query);
+    }
+    glQueryCounter(set.Queries[query], GL_TIMESTAMP);
+    set.Labels.push_back(Label{ section, command });
+}
+
+bool GpuTimer::Collect(QuerySet& set)
+{
+    GLint available = 0;
+    glGetQueryObjectiv(set.Queries[set.Labels.size()], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    GpuTimings timings{ .Frame = set.Frame };
+    m_LastCommands.assign(set.Commands, 0.0);
+    GLuint64 previous = 0;
+    glGetQueryObjectui64v(set.Queries[0], GL_QUERY_RESULT, &previous);
+    const GLuint64 start = previous;
+    for (size_t i = 0; i < set.Labels.size(); ++i) {
+        GLuint64 timestamp = 0;
+        glGetQueryObjectui64v(set.Queries[i + 1], GL_QUERY_RESULT, &timestamp);
+        double ms = static_cast<double>(timestamp - previous) / 1e6;
+        previous = timestamp;
+
+        const auto& label = set.Labels[i];
+        switch (label.Section) {
+        case GpuSection::Clear: timings.ClearMs += ms; break;
+        case GpuSection::Upload: timings.UploadMs += ms; break;
+        case GpuSection::Draw: timings.DrawMs += ms; break;
+        case GpuSection::Primitives: timings.PrimitivesMs += ms; break;
+        case GpuSection::Present: timings.PresentMs += ms; break;
+        case GpuSection::Other: timings.OtherMs += ms; break;
+        }
+        if (label.Command != NotACommand) {
+            m_LastCommands[label.Command] = ms;
+        }
+    }
+    timings.TotalMs = static_cast<double>(previous - start) / 1e6;
+
+    m_Last = timings;
+    set.Pending = false;
+    return true;
+}
+
+} // gfx
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "RendererStats.h"
+
+namespace gfx
+{
+
+enum class GpuSection : uint8_t {
+    Other,
+    Clear,
+    Upload,
+    Draw,
+    Primitives,
+    Present,
+};
+
+/* Where the GPU time of a frame goes, without waiting for the GPU.
+ * Every Mark writes a GL_TIMESTAMP query, the time since the previous one is the section's:
+ * one query per boundary, where GL_TIME_ELAPSED pairs would need two and cannot nest.
+ * The queries of a frame are a set in a ring of FrameCount, read back at the BeginFrame of later frames
+ * once the GPU has reached them; a set still running when its turn comes again is dropped, never waited for.
+ * Every draw command gets a mark, a set starts with InitialMarks queries and doubles when a frame needs more.
+ * Without timestamp support (GL_QUERY_COUNTER_BITS of 0) nothing is measured. */
+class GpuTimer {
+public:
+    constexpr static size_t FrameCount = 4;
+    constexpr static size_t InitialMarks = 256;
+
+    GpuTimer() = default;
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // the queries are created at the first frame with a context current, not before
+    void SetEnabled(bool enabled) noexcept;
+    constexpr bool Enabled() const noexcept { return m_Enabled; }
+    constexpr bool Recording() const noexcept { return m_Recording; }
+
+    // reads the finished frames back and starts a new one, does nothing when disabled
+    void BeginFrame();
+    // the GPU work since the previous mark was section
+    void Mark(GpuSection section);
+    // the GPU work since the previous mark was the next draw command of the frame
+    void MarkCommand();
+    void EndFrame();
+
+    // the last frame read back, and the GPU time of each of its commands, in the order they ran
+    constexpr const GpuTimings& Last() const noexcept { return m_Last; }
+    std::span<const double> CommandMs() const noexcept { return m_LastCommands; }
+    constexpr size_t Dropped() const noexcept { return m_Dropped; }
+
+private:
+    constexpr static uint32_t NotACommand = UINT32_MAX;
+
+    struct Label {
+        GpuSection Section;
+        uint32_t Command;
+    };
+
+    struct QuerySet {
+        std::vector<GLuint> Queries;
+        std::vector<Label> Labels; // of every query but the first, the start of the frame
+        size_t Frame{ 0 };
+        uint32_t Commands{ 0 };
+        bool Pending{ false };
+    };
+
+    void Write(GpuSection section, uint32_t command);
+    // false while the GPU has not reached the end of the set
+    bool Collect(QuerySet& set);
+
+    std::array<QuerySet, FrameCount> m_Sets;
+    size_t m_Current{ 0 };
+    size_t m_Frame{ 0 };
+    size_t m_Dropped{ 0 };
+    bool m_Enabled{ false };
+    bool m_Supported{ false };
+    bool m_Checked{ false };
+    bool m_Recording{ false };
+    GpuTimings m_Last;
+    std::vector<double> m_LastCommands;
+};
+
+} // gfx
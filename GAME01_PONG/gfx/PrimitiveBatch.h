@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../math/math.h"
+#include "GpuBuffer.h"
+#include "ShaderRegistry.h"
+#include "VertexArray.h"
+#include "VertexFormat.h"
+
+namespace gfx
+{
+
+struct PrimitiveVertex {
+    float X, Y, Z;
+    float Size; // point size in pixels, only read by points
+    uint32_t Tint;
+};
+
+/* Untextured colored geometry for debug drawing: boxes, vectors, markers.
+ * Primitives are triangles (filled rects and thick lines expanded on the CPU), hairlines and points,
+ * accumulated in a single stream in submission order and uploaded with one call. Consecutive primitives
+ * of the same kind are a run, drawn with one call: a rect submitted after a line is drawn over it.
+ * They go over the sprites: no depth test, blended.
+ * The batch has its own program, the material ids of the sprites are not shared with it. */
+class PrimitiveBatch {
+public:
+    constexpr static const char* VertexShader =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "layout (location = 1) in float size;\n"
+        "layout (location = 2) in vec4 tint;\n"
+        "layout (std140) uniform Frame {\n"
+        "   mat4 projection;\n"
+        "   vec2 camera;\n"
+        "   float time;\n"
+        "};\n"
+        "out vec4 out_tint;\n"
+        "void main() {\n"
+        "   gl_Position = projection * vec4(pos.xy - camera, pos.z, 1.0);\n"
+        "   gl_PointSize = size;\n"
+        "   out_tint = tint;\n"
+        "}\n";
+
+    constexpr static const char* FragmentShader =
+        "#version 330 core\n"
+        "in vec4 out_tint;\n"
+        "out vec4 FragColor;\n"
+        "void main() {\n"
+        "   FragColor = out_tint;\n"
+        "}\n";
+
+    PrimitiveBatch()
+        : m_VertexBuffer{ GpuBuffer::Target::ArrayBuffer }
+    {
+    }
+
+    PrimitiveBatch(const PrimitiveBatch&) = delete;
+    PrimitiveBatch& operator=(const PrimitiveBatch&) = delete;
+
+    /* Builds the program, with a GL context current. false when it does not build:
+     * the primitives are then dropped at Flush, never drawn with another program. */
+    bool Init(ShaderCache* cache, GLuint frame_block_binding)
+    {
+        m_Program = m_Shaders.Create(VertexShader, FragmentShader, {}, {}, cache, frame_block_binding);
+        return m_Program != InvalidMaterial;
+    }
+
+    void FillRect(const math::Bbox& bbox, const math::Color& color)
+    {
+        const float x0 = bbox.Pos.x(), y0 = bbox.Pos.y();
+        const float x1 = x0 + bbox.Size.x(), y1 = y0 + bbox.Size.y();
+        PushQuad(x0, y0, x0, y1, x1, y0, x1, y1, PackTint(color));
+    }
+
+    // the outline grows inside bbox
+    void DrawRect(const math::Bbox& bbox, const math::Color& color, float thickness = 1.0f)
+    {
+        const float x0 = bbox.Pos.x(), y0 = bbox.Pos.y();
+        const float x1 = x0 + bbox.Size.x(), y1 = y0 + bbox.Size.y();
+        if (thickness <= 1.0f) {
+            auto tint = PackTint(color);
+            PushLine(x0, y0, x1, y0, tint);
+            PushLine(x1, y0, x1, y1, tint);
+            PushLine(x1, y1, x0, y1, tint);
+            PushLine(x0, y1, x0, y0, tint);
+            return;
+        }
+
+        float t = std::min({ thickness, bbox.Size.x() * 0.5f, bbox.Size.y() * 0.5f });
+        FillRect(math::Bbox{ x0, y0, bbox.Size.x(), t }, color);
+        FillRect(math::Bbox{ x0, y1 - t, bbox.Size.x(), t }, color);
+        FillRect(math::Bbox{ x0, y0 + t, t, bbox.Size.y() - 2.0f * t }, color);
+        FillRect(math::Bbox{ x1 - t, y0 + t, t, bbox.Size.y() - 2.0f * t }, color);
+    }
+
+    // lines up to a pixel thick are GL lines, thicker ones are quads around the segment
+    void DrawLine(math::Vec2<float> from, math::Vec2<float> to, const math::Color& color, float thickness = 1.0f)
+    {
+        auto tint = PackTint(color);
+        if (thickness <= 1.0f) {
+            PushLine(from.x(), from.y(), to.x(), to.y(), tint);
+            return;
+        }
+
+        float dx = to.x() - from.x();
+        float dy = to.y() - from.y();
+        float length = std::sqrt(dx * dx + dy * dy);
+        if (length == 0.0f) return;
+
+        float nx = -dy / length * thickness * 0.5f;
+        float ny = dx / length * thickness * 0.5f;
+        PushQuad(
+            from.x() + nx, from.y() + ny, from.x() - nx, from.y() - ny,
+            to.x() + nx, to.y() + ny, to.x() - nx, to.y() - ny,
+            tint
+        );
+    }
+
+    void DrawPoint(math::Vec2<float> position, const math::Color& color, float size = 1.0f)
+    {
+        Push(GL_POINTS, { PrimitiveVertex{ position.x(), position.y(), 0.0f, size, PackTint(color) } });
+    }
+
+    constexpr bool Empty() const noexcept
+    {
+        return m_Vertices.empty();
+    }
+
+    // the number of primitives submitted, a thick line or a rect counts as its pieces
+    constexpr size_t Size() const noexcept
+    {
+        return m_Primitives;
+    }
+
+    // bytes given to the vertex buffer since the last call
+    constexpr size_t TakeUploadedBytes() noexcept
+    {
+        return std::exchange(m_UploadedBytes, 0);
+    }
+
+    /* Uploads the stream, draws its runs in order and clears it.
+     * Returns the number of draw calls. Leaves depth writes off and blending on. */
+    size_t Flush()
+    {
+        if (Empty()) return 0;
+        if (m_Program == InvalidMaterial) {
+            Clear();
+            return 0;
+        }
+
+        size_t vertex_count = m_Vertices.size();
+        m_VertexBuffer.Bind();
+        if (!m_LayoutSet) SetLayout();
+        if (vertex_count > m_Capacity) m_Capacity = std::max(vertex_count, m_Capacity * 2);
+        // orphaned, last frame's draws may still read it
+        m_VertexBuffer.Allocate(m_Capacity * sizeof(PrimitiveVertex), GpuBuffer::Usage::StreamDraw);
+        m_VertexBuffer.SetData(m_Vertices.data(), vertex_count, 0);
+        m_VertexBuffer.Unbind();
+        m_UploadedBytes += vertex_count * sizeof(PrimitiveVertex);
+
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        m_Shaders.Use(m_Program);
+        m_VertexArray.Bind();
+
+        for (const auto& run : m_Runs) {
+            glDrawArrays(run.Mode, static_cast<GLint>(run.First), static_cast<GLsizei>(run.Count));
+        }
+        const size_t draw_calls = m_Runs.size();
+
+        m_VertexArray.Unbind();
+        glDisable(GL_PROGRAM_POINT_SIZE);
+        glEnable(GL_DEPTH_TEST);
+
+        Clear();
+        return draw_calls;
+    }
+
+private:
+    // consecutive vertices of one kind of primitive
+    struct Run {
+        GLenum Mode;
+        size_t First;
+        size_t Count;
+    };
+
+    // expects the vertex buffer to be bound
+    void SetLayout()
+    {
+        m_VertexArray.Bind();
+        m_VertexArray.SetAttribute(0, 3, GL_FLOAT, sizeof(PrimitiveVertex), offsetof(PrimitiveVertex, X));
+        m_VertexArray.SetAttribute(1, 1, GL_FLOAT, sizeof(PrimitiveVertex), offsetof(PrimitiveVertex, Size));
+        m_VertexArray.SetAttribute(2, 4, GL_UNSIGNED_BYTE, sizeof(PrimitiveVertex), offsetof(PrimitiveVertex, Tint), true);
+        m_VertexArray.Unbind();
+        m_LayoutSet = true;
+    }
+
+    // corners in the order of a sprite: a and b on one side, c and d on the other
+    void PushQuad(float ax, float ay, float bx, float by, float cx, float cy, float dx, float dy, uint32_t tint)
+    {
+        PrimitiveVertex a{ ax, ay, 0.0f, 1.0f, tint };
+        PrimitiveVertex b{ bx, by, 0.0f, 1.0f, tint };
+        PrimitiveVertex c{ cx, cy, 0.0f, 1.0f, tint };
+        PrimitiveVertex d{ dx, dy, 0.0f, 1.0f, tint };
+        Push(GL_TRIANGLES, { a, b, c, c, b, d });
+    }
+
+    void PushLine(float ax, float ay, float bx, float by, uint32_t tint)
+    {
+        Push(GL_LINES, { PrimitiveVertex{ ax, ay, 0.0f, 1.0f, tint }, PrimitiveVertex{ bx, by, 0.0f, 1.0f, tint } });
+    }
+
+    // one primitive, it extends the last run when it is of the same kind
+    void Push(GLenum mode, std::initializer_list<PrimitiveVertex> vertices)
+    {
+        if (m_Runs.empty() || m_Runs.back().Mode != mode) {
+            m_Runs.push_back(Run{ mode, m_Vertices.size(), 0 });
+        }
+        m_Vertices.insert(m_Vertices.end(), vertices);
+        m_Runs.back().Count += vertices.size();
+        m_Primitives++;
+    }
+
+    void Clear() noexcept
+    {
+        m_Vertices.clear();
+        m_Runs.clear();
+        m_Primitives = 0;
+    }
+
+    ShaderRegistry m_Shaders;
+    MaterialId m_Program{ InvalidMaterial };
+    gfx::VertexArray m_VertexArray;
+    GpuBuffer m_VertexBuffer;
+    size_t m_Capacity{ 0 };
+    size_t m_UploadedBytes{ 0 };
+    bool m_LayoutSet{ false };
+
+    std::vector<PrimitiveVertex> m_Vertices;
+    std::vector<Run> m_Runs;
+    size_t m_Primitives{ 0 };
+};
+
+static_assert(sizeof(PrimitiveVertex) == 20);
+
+} // gfx
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GpuBuffer.h"
+
+namespace gfx
+{
+
+/* Indices of Capacity quads, built once: quad q is the triangles (4q, 4q+1, 4q+2) and (4q+2, 4q+1, 4q+3),
+ * the strip order the vertex formats write. Any run of consecutive sprites of a vertex buffer is then
+ * one indexed draw, an offset into this buffer or a base vertex, instead of a first/count pair per sprite.
+ * 16-bit indices while they can address every vertex, 32-bit past 16384 quads. */
+class QuadIndexBuffer {
+public:
+    constexpr static size_t IndicesPerQuad = 6;
+    constexpr static size_t VerticesPerQuad = 4;
+    // as many quads as 16-bit indices can address, runs up to this length always fit
+    constexpr static size_t MinCapacity = 0x10000 / VerticesPerQuad;
+
+    QuadIndexBuffer()
+        : m_IndexBuffer{ GpuBuffer::Target::ElementArrayBuffer }
+    {
+    }
+
+    QuadIndexBuffer(const QuadIndexBuffer&) = delete;
+    QuadIndexBuffer& operator=(const QuadIndexBuffer&) = delete;
+
+    void Allocate(size_t quads)
+    {
+        quads = std::max(quads, MinCapacity);
+        m_Capacity = quads;
+        m_Type = quads * VerticesPerQuad <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        m_IndexBuffer.Bind();
+        if (m_Type == GL_UNSIGNED_SHORT) {
+            auto indices = Build<uint16_t>(quads);
+            m_IndexBuffer.Allocate(indices.size() * sizeof(uint16_t), GpuBuffer::Usage::StaticDraw);
+            m_IndexBuffer.SetData(indices.data(), indices.size());
+        } else {
+            auto indices = Build<uint32_t>(quads);
+            m_IndexBuffer.Allocate(indices.size() * sizeof(uint32_t), GpuBuffer::Usage::StaticDraw);
+            m_IndexBuffer.SetData(indices.data(), indices.size());
+        }
+        m_IndexBuffer.Unbind();
+    }
+
+    // the element buffer binding is part of the vertex array: expects the vertex array to be bound
+    void Bind() const noexcept
+    {
+        m_IndexBuffer.Bind();
+    }
+
+    // draws quads [first, first + count) of the bound vertex array
+    void Draw(size_t first, size_t count) const noexcept
+    {
+        auto index_count = static_cast<GLsizei>(count * IndicesPerQuad);
+        if (first + count <= m_Capacity) {
+            glDrawElements(GL_TRIANGLES, index_count, m_Type, Offset(first));
+            return;
+        }
+
+        // past the indices, the same run is addressed from the start of the buffer
+        glDrawElementsBaseVertex(GL_TRIANGLES, index_count, m_Type, nullptr, static_cast<GLint>(first * VerticesPerQuad));
+    }
+
+    /* One call for many runs, counts are in indices and every run starts at its base vertex.
+     * A run cannot be longer than Capacity quads. */
+    void MultiDraw(const GLsizei* index_counts, const GLint* base_vertices, GLsizei draw_count) const noexcept
+    {
+        if (m_NullOffsets.size() < static_cast<size_t>(draw_count)) {
+            m_NullOffsets.resize(draw_count, nullptr);
+        }
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, index_counts, m_Type, m_NullOffsets.data(), draw_count, base_vertices);
+    }
+
+    constexpr size_t Capacity() const noexcept
+    {
+        return m_Capacity;
+    }
+
+    constexpr size_t SizeBytes() const noexcept
+    {
+        return m_Capacity * IndicesPerQuad * (m_Type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+    }
+
+    constexpr GLenum Type() const noexcept
+    {
+        return m_Type;
+    }
+
+private:
+    template <typename Index>
+    static std::vector<Index> Build(size_t quads)
+    {
+        std::vector<Index> indices;
+        indices.reserve(quads * IndicesPerQuad);
+        for (size_t quad = 0; quad < quads; ++quad) {
+            auto base = static_cast<Index>(quad * VerticesPerQuad);
+            for (Index corner : { 0, 1, 2, 2, 1, 3 }) {
+                indices.push_back(static_cast<Index>(base + corner));
+            }
+        }
+        return indices;
+    }
+
+    const void* Offset(size_t quad) const noexcept
+    {
+        size_t index_size = m_Type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        return reinterpret_cast<const void*>(quad * IndicesPerQuad * index_size);
+    }
+
+    GpuBuffer m_IndexBuffer;
+    size_t m_Capacity{ 0 };
+    GLenum m_Type{ GL_UNSIGNED_SHORT };
+    mutable std::vector<const void*> m_NullOffsets;
+};
+
+} // gfx
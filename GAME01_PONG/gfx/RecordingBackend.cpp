@@ -0,0 +1,601 @@
+#include "RecordingBackend.h"
+#include "../Platform.h"
+
+#include <cstring>
+
+namespace gfx
+{
+
+static RecordingBackend* s_Current = nullptr;
+
+namespace
+{
+
+void Record(const char* name, GlCallKind kind, uint32_t target = 0, uint32_t object = 0, uint64_t size = 0)
+{
+    if (s_Current) s_Current->Record(name, kind, target, object, size);
+}
+
+uint64_t PixelBytes(GLsizei width, GLsizei height, GLenum format, GLenum type) noexcept
+{
+    uint64_t components = 4;
+    switch (format) {
+    case GL_RED: case GL_DEPTH_COMPONENT: components = 1; break;
+    case GL_RG: components = 2; break;
+    case GL_RGB: case GL_BGR: components = 3; break;
+    }
+    uint64_t component_size = type == GL_FLOAT || type == GL_UNSIGNED_INT ? 4 : type == GL_HALF_FLOAT || type == GL_UNSIGNED_SHORT ? 2 : 1;
+    return static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * components * component_size;
+}
+
+/* objects */
+
+void APIENTRY GenNames(GLsizei n, GLuint* names)
+{
+    for (GLsizei i = 0; i < n; ++i) {
+        names[i] = s_Current ? s_Current->NextName() : 0;
+    }
+    Record("glGen*", GlCallKind::Other, 0, static_cast<uint32_t>(n));
+}
+
+void APIENTRY DeleteNames(GLsizei n, const GLuint*)
+{
+    Record("glDelete*", GlCallKind::Other, 0, static_cast<uint32_t>(n));
+}
+
+GLuint APIENTRY CreateShader(GLenum type)
+{
+    Record("glCreateShader", GlCallKind::Other, type);
+    return s_Current ? s_Current->NextName() : 0;
+}
+
+GLuint APIENTRY CreateProgram()
+{
+    Record("glCreateProgram", GlCallKind::Other);
+    return s_Current ? s_Current->NextName() : 0;
+}
+
+void APIENTRY DeleteObject(GLuint object)
+{
+    Record("glDelete*", GlCallKind::Other, 0, object);
+}
+
+/* shaders and programs, they always build and have nothing active */
+
+void APIENTRY ShaderSource(GLuint shader, GLsizei, const GLchar* const*, const GLint*)
+{
+    Record("glShaderSource", GlCallKind::Other, 0, shader);
+}
+
+void APIENTRY CompileShader(GLuint shader)
+{
+    Record("glCompileShader", GlCallKind::Other, 0, shader);
+}
+
+void APIENTRY AttachShader(GLuint program, GLuint)
+{
+    Record("glAttachShader", GlCallKind::Other, 0, program);
+}
+
+void APIENTRY LinkProgram(GLuint program)
+{
+    Record("glLinkProgram", GlCallKind::Other, 0, program);
+}
+
+void APIENTRY GetObjectiv(GLuint, GLenum pname, GLint* params)
+{
+    *params = pname == GL_COMPILE_STATUS || pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+void APIENTRY GetInfoLog(GLuint, GLsizei buffer_size, GLsizei* length, GLchar* log)
+{
+    if (length) *length = 0;
+    if (log && buffer_size > 0) log[0] = '\0';
+}
+
+GLint APIENTRY GetUniformLocation(GLuint, const GLchar*)
+{
+    return -1;
+}
+
+void APIENTRY GetActiveUniform(GLuint, GLuint, GLsizei buffer_size, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+    GetInfoLog(0, buffer_size, length, name);
+    *size = 0;
+    *type = 0;
+}
+
+void APIENTRY GetActiveUniformBlockName(GLuint, GLuint, GLsizei buffer_size, GLsizei* length, GLchar* name)
+{
+    GetInfoLog(0, buffer_size, length, name);
+}
+
+void APIENTRY GetActiveUniformBlockiv(GLuint, GLuint, GLenum, GLint* params)
+{
+    *params = 0;
+}
+
+void APIENTRY UniformBlockBinding(GLuint program, GLuint, GLuint binding)
+{
+    Record("glUniformBlockBinding", GlCallKind::Other, binding, program);
+}
+
+void APIENTRY UseProgram(GLuint program)
+{
+    Record("glUseProgram", GlCallKind::Program, 0, program);
+}
+
+/* uniforms */
+
+void APIENTRY Uniform1i(GLint location, GLint)
+{
+    Record("glUniform1i", GlCallKind::Uniform, static_cast<uint32_t>(location));
+}
+
+void APIENTRY Uniform1f(GLint location, GLfloat)
+{
+    Record("glUniform1f", GlCallKind::Uniform, static_cast<uint32_t>(location));
+}
+
+void APIENTRY Uniformfv(GLint location, GLsizei count, const GLfloat*)
+{
+    Record("glUniform*fv", GlCallKind::Uniform, static_cast<uint32_t>(location), static_cast<uint32_t>(count));
+}
+
+void APIENTRY UniformMatrix4fv(GLint location, GLsizei count, GLboolean, const GLfloat*)
+{
+    Record("glUniformMatrix4fv", GlCallKind::Uniform, static_cast<uint32_t>(location), static_cast<uint32_t>(count));
+}
+
+void APIENTRY GetUniformiv(GLuint, GLint, GLint* params)
+{
+    *params = 0;
+}
+
+void APIENTRY GetUniformfv(GLuint, GLint, GLfloat* params)
+{
+    *params = 0.0f;
+}
+
+/* binds */
+
+void APIENTRY BindBuffer(GLenum target, GLuint buffer)
+{
+    Record("glBindBuffer", GlCallKind::Bind, target, buffer);
+}
+
+void APIENTRY BindBufferBase(GLenum target, GLuint, GLuint buffer)
+{
+    Record("glBindBufferBase", GlCallKind::Bind, target, buffer);
+}
+
+void APIENTRY BindTexture(GLenum target, GLuint texture)
+{
+    Record("glBindTexture", GlCallKind::Bind, target, texture);
+}
+
+void APIENTRY BindVertexArray(GLuint array)
+{
+    Record("glBindVertexArray", GlCallKind::Bind, 0, array);
+}
+
+void APIENTRY BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    Record("glBindFramebuffer", GlCallKind::Bind, target, framebuffer);
+}
+
+void APIENTRY ActiveTexture(GLenum texture)
+{
+    Record("glActiveTexture", GlCallKind::State, texture);
+}
+
+/* state */
+
+void APIENTRY Enable(GLenum capability)
+{
+    Record("glEnable", GlCallKind::State, capability);
+}
+
+void APIENTRY Disable(GLenum capability)
+{
+    Record("glDisable", GlCallKind::State, capability);
+}
+
+void APIENTRY BlendFunc(GLenum source, GLenum)
+{
+    Record("glBlendFunc", GlCallKind::State, source);
+}
+
+void APIENTRY DepthMask(GLboolean flag)
+{
+    Record("glDepthMask", GlCallKind::State, flag);
+}
+
+void APIENTRY DepthFunc(GLenum function)
+{
+    Record("glDepthFunc", GlCallKind::State, function);
+}
+
+void APIENTRY Viewport(GLint, GLint, GLsizei width, GLsizei height)
+{
+    Record("glViewport", GlCallKind::State, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+}
+
+void APIENTRY ClearColor(GLfloat, GLfloat, GLfloat, GLfloat)
+{
+    Record("glClearColor", GlCallKind::State);
+}
+
+void APIENTRY Clear(GLbitfield mask)
+{
+    Record("glClear", GlCallKind::Clear, mask);
+}
+
+/* vertex layout */
+
+void APIENTRY VertexAttribPointer(GLuint index, GLint, GLenum type, GLboolean, GLsizei, const void*)
+{
+    Record("glVertexAttribPointer", GlCallKind::Other, type, index);
+}
+
+void APIENTRY EnableVertexAttribArray(GLuint index)
+{
+    Record("glEnableVertexAttribArray", GlCallKind::Other, 0, index);
+}
+
+void APIENTRY DisableVertexAttribArray(GLuint index)
+{
+    Record("glDisableVertexAttribArray", GlCallKind::Other, 0, index);
+}
+
+/* uploads */
+
+void APIENTRY BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+    // without data it is an allocation (or an orphaning), nothing is sent
+    Record("glBufferData", data ? GlCallKind::Upload : GlCallKind::Other, target, 0, data ? static_cast<uint64_t>(size) : 0);
+}
+
+void APIENTRY BufferSubData(GLenum target, GLintptr, GLsizeiptr size, const void*)
+{
+    Record("glBufferSubData", GlCallKind::Upload, target, 0, static_cast<uint64_t>(size));
+}
+
+void* APIENTRY MapBufferRange(GLenum target, GLintptr, GLsizeiptr length, GLbitfield)
+{
+    Record("glMapBufferRange", GlCallKind::Upload, target, 0, static_cast<uint64_t>(length));
+    return s_Current ? s_Current->Scratch(static_cast<size_t>(length)) : nullptr;
+}
+
+GLboolean APIENTRY UnmapBuffer(GLenum target)
+{
+    Record("glUnmapBuffer", GlCallKind::Other, target);
+    return GL_TRUE;
+}
+
+void APIENTRY TexImage2D(GLenum target, GLint level, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels)
+{
+    Record("glTexImage2D", pixels ? GlCallKind::Upload : GlCallKind::Other, target, static_cast<uint32_t>(level), pixels ? PixelBytes(width, height, format, type) : 0);
+}
+
+void APIENTRY TexSubImage2D(GLenum target, GLint level, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*)
+{
+    Record("glTexSubImage2D", GlCallKind::Upload, target, static_cast<uint32_t>(level), PixelBytes(width, height, format, type));
+}
+
+void APIENTRY CompressedTexImage2D(GLenum target, GLint level, GLenum, GLsizei, GLsizei, GLint, GLsizei size, const void*)
+{
+    Record("glCompressedTexImage2D", GlCallKind::Upload, target, static_cast<uint32_t>(level), static_cast<uint64_t>(size));
+}
+
+void APIENTRY TexParameteri(GLenum target, GLenum pname, GLint)
+{
+    Record("glTexParameteri", GlCallKind::State, target, pname);
+}
+
+void APIENTRY GenerateMipmap(GLenum target)
+{
+    Record("glGenerateMipmap", GlCallKind::Other, target);
+}
+
+/* framebuffers */
+
+void APIENTRY FramebufferTexture2D(GLenum target, GLenum, GLenum, GLuint texture, GLint)
+{
+    Record("glFramebufferTexture2D", GlCallKind::Other, target, texture);
+}
+
+GLenum APIENTRY CheckFramebufferStatus(GLenum)
+{
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void APIENTRY ReadBuffer(GLenum source)
+{
+    Record("glReadBuffer", GlCallKind::State, source);
+}
+
+// into a pixel pack buffer or memory, either way nothing is written
+void APIENTRY ReadPixels(GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, void*)
+{
+    Record("glReadPixels", GlCallKind::Other, format, 0, PixelBytes(width, height, format, type));
+}
+
+void APIENTRY BlitFramebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum)
+{
+    Record("glBlitFramebuffer", GlCallKind::Other, mask, 0, static_cast<uint64_t>(dst_x1) * static_cast<uint64_t>(dst_y1));
+}
+
+/* draws */
+
+void APIENTRY DrawArrays(GLenum mode, GLint, GLsizei count)
+{
+    Record("glDrawArrays", GlCallKind::Draw, mode, 1, static_cast<uint64_t>(count));
+}
+
+void APIENTRY DrawElements(GLenum mode, GLsizei count, GLenum, const void*)
+{
+    Record("glDrawElements", GlCallKind::Draw, mode, 1, static_cast<uint64_t>(count));
+}
+
+void APIENTRY DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum, const void*, GLint)
+{
+    Record("glDrawElementsBaseVertex", GlCallKind::Draw, mode, 1, static_cast<uint64_t>(count));
+}
+
+uint64_t Sum(const GLsizei* counts, GLsizei draw_count) noexcept
+{
+    uint64_t sum = 0;
+    for (GLsizei i = 0; i < draw_count; ++i) sum += static_cast<uint64_t>(counts[i]);
+    return sum;
+}
+
+void APIENTRY MultiDrawArrays(GLenum mode, const GLint*, const GLsizei* counts, GLsizei draw_count)
+{
+    Record("glMultiDrawArrays", GlCallKind::Draw, mode, static_cast<uint32_t>(draw_count), Sum(counts, draw_count));
+}
+
+void APIENTRY MultiDrawElements(GLenum mode, const GLsizei* counts, GLenum, const void* const*, GLsizei draw_count)
+{
+    Record("glMultiDrawElements", GlCallKind::Draw, mode, static_cast<uint32_t>(draw_count), Sum(counts, draw_count));
+}
+
+void APIENTRY MultiDrawElementsBaseVertex(GLenum mode, const GLsizei* counts, GLenum, const void* const*, GLsizei draw_count, const GLint*)
+{
+    Record("glMultiDrawElementsBaseVertex", GlCallKind::Draw, mode, static_cast<uint32_t>(draw_count), Sum(counts, draw_count));
+}
+
+/* syncs, always signaled */
+
+GLsync APIENTRY FenceSync(GLenum, GLbitfield)
+{
+    Record("glFenceSync", GlCallKind::Other);
+    static int fence;
+    return reinterpret_cast<GLsync>(&fence);
+}
+
+GLenum APIENTRY ClientWaitSync(GLsync, GLbitfield, GLuint64)
+{
+    return GL_ALREADY_SIGNALED;
+}
+
+void APIENTRY DeleteSync(GLsync)
+{
+}
+
+void APIENTRY Finish()
+{
+    Record("glFinish", GlCallKind::Other);
+}
+
+/* timer queries, always available and always at 0 */
+
+void APIENTRY QueryCounter(GLuint query, GLenum target)
+{
+    Record("glQueryCounter", GlCallKind::Other, target, query);
+}
+
+void APIENTRY GetQueryiv(GLenum, GLenum, GLint* data)
+{
+    *data = 64;
+}
+
+void APIENTRY GetQueryObjectiv(GLuint, GLenum, GLint* data)
+{
+    *data = 1;
+}
+
+void APIENTRY GetQueryObjectui64v(GLuint, GLenum, GLuint64* data)
+{
+    *data = 0;
+}
+
+/* queries, what glad asks for to load and what the renderer checks */
+
+const GLubyte* APIENTRY GetString(GLenum name)
+{
+    switch (name) {
+    case GL_VERSION: return reinterpret_cast<const GLubyte*>("3.3.0 Recording");
+    case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("3.30");
+    case GL_VENDOR: return reinterpret_cast<const GLubyte*>("GAME01_PONG");
+    case GL_RENDERER: return reinterpret_cast<const GLubyte*>("RecordingBackend");
+    }
+    return reinterpret_cast<const GLubyte*>("");
+}
+
+// glad fails to load without at least one extension, this one promises nothing
+const GLubyte* APIENTRY GetStringi(GLenum, GLuint)
+{
+    return reinterpret_cast<const GLubyte*>("GL_GAME01_recording");
+}
+
+void APIENTRY GetIntegerv(GLenum pname, GLint* data)
+{
+    switch (pname) {
+    case GL_MAX_TEXTURE_SIZE: *data = 16384; break;
+    case GL_MAX_TEXTURE_IMAGE_UNITS: *data = 16; break;
+    case GL_MAJOR_VERSION: *data = 3; break;
+    case GL_MINOR_VERSION: *data = 3; break;
+    case GL_NUM_EXTENSIONS: *data = 1; break;
+    default: *data = 0; break; // no program binary formats
+    }
+}
+
+GLenum APIENTRY GetError()
+{
+    return GL_NO_ERROR;
+}
+
+struct EntryPoint {
+    const char* Name;
+    void* Proc;
+};
+
+template <typename F>
+void* Proc(F* function) noexcept
+{
+    return reinterpret_cast<void*>(function);
+}
+
+const EntryPoint s_EntryPoints[] = {
+    { "glGenBuffers", Proc(GenNames) },
+    { "glGenTextures", Proc(GenNames) },
+    { "glGenVertexArrays", Proc(GenNames) },
+    { "glGenFramebuffers", Proc(GenNames) },
+    { "glDeleteBuffers", Proc(DeleteNames) },
+    { "glDeleteTextures", Proc(DeleteNames) },
+    { "glDeleteVertexArrays", Proc(DeleteNames) },
+    { "glDeleteFramebuffers", Proc(DeleteNames) },
+    { "glGenQueries", Proc(GenNames) },
+    { "glDeleteQueries", Proc(DeleteNames) },
+    { "glCreateShader", Proc(CreateShader) },
+    { "glCreateProgram", Proc(CreateProgram) },
+    { "glDeleteShader", Proc(DeleteObject) },
+    { "glDeleteProgram", Proc(DeleteObject) },
+    { "glShaderSource", Proc(ShaderSource) },
+    { "glCompileShader", Proc(CompileShader) },
+    { "glAttachShader", Proc(AttachShader) },
+    { "glLinkProgram", Proc(LinkProgram) },
+    { "glGetShaderiv", Proc(GetObjectiv) },
+    { "glGetProgramiv", Proc(GetObjectiv) },
+    { "glGetShaderInfoLog", Proc(GetInfoLog) },
+    { "glGetProgramInfoLog", Proc(GetInfoLog) },
+    { "glGetUniformLocation", Proc(GetUniformLocation) },
+    { "glGetActiveUniform", Proc(GetActiveUniform) },
+    { "glGetActiveUniformBlockName", Proc(GetActiveUniformBlockName) },
+    { "glGetActiveUniformBlockiv", Proc(GetActiveUniformBlockiv) },
+    { "glUniformBlockBinding", Proc(UniformBlockBinding) },
+    { "glUseProgram", Proc(UseProgram) },
+    { "glUniform1i", Proc(Uniform1i) },
+    { "glUniform1f", Proc(Uniform1f) },
+    { "glUniform2fv", Proc(Uniformfv) },
+    { "glUniform3fv", Proc(Uniformfv) },
+    { "glUniform4fv", Proc(Uniformfv) },
+    { "glUniformMatrix4fv", Proc(UniformMatrix4fv) },
+    { "glGetUniformiv", Proc(GetUniformiv) },
+    { "glGetUniformfv", Proc(GetUniformfv) },
+    { "glBindBuffer", Proc(BindBuffer) },
+    { "glBindBufferBase", Proc(BindBufferBase) },
+    { "glBindTexture", Proc(BindTexture) },
+    { "glBindVertexArray", Proc(BindVertexArray) },
+    { "glBindFramebuffer", Proc(BindFramebuffer) },
+    { "glActiveTexture", Proc(ActiveTexture) },
+    { "glEnable", Proc(Enable) },
+    { "glDisable", Proc(Disable) },
+    { "glBlendFunc", Proc(BlendFunc) },
+    { "glDepthMask", Proc(DepthMask) },
+    { "glDepthFunc", Proc(DepthFunc) },
+    { "glViewport", Proc(Viewport) },
+    { "glClearColor", Proc(ClearColor) },
+    { "glClear", Proc(Clear) },
+    { "glVertexAttribPointer", Proc(VertexAttribPointer) },
+    { "glEnableVertexAttribArray", Proc(EnableVertexAttribArray) },
+    { "glDisableVertexAttribArray", Proc(DisableVertexAttribArray) },
+    { "glBufferData", Proc(BufferData) },
+    { "glBufferSubData", Proc(BufferSubData) },
+    { "glMapBufferRange", Proc(MapBufferRange) },
+    { "glUnmapBuffer", Proc(UnmapBuffer) },
+    { "glTexImage2D", Proc(TexImage2D) },
+    { "glTexSubImage2D", Proc(TexSubImage2D) },
+    { "glCompressedTexImage2D", Proc(CompressedTexImage2D) },
+    { "glTexParameteri", Proc(TexParameteri) },
+    { "glGenerateMipmap", Proc(GenerateMipmap) },
+    { "glFramebufferTexture2D", Proc(FramebufferTexture2D) },
+    { "glCheckFramebufferStatus", Proc(CheckFramebufferStatus) },
+    { "glReadBuffer", Proc(ReadBuffer) },
+    { "glReadPixels", Proc(ReadPixels) },
+    { "glBlitFramebuffer", Proc(BlitFramebuffer) },
+    { "glDrawArrays", Proc(DrawArrays) },
+    { "glDrawElements", Proc(DrawElements) },
+    { "glDrawElementsBaseVertex", Proc(DrawElementsBaseVertex) },
+    { "glMultiDrawArrays", Proc(MultiDrawArrays) },
+    { "glMultiDrawElements", Proc(MultiDrawElements) },
+    { "glMultiDrawElementsBaseVertex", Proc(MultiDrawElementsBaseVertex) },
+    { "glFenceSync", Proc(FenceSync) },
+    { "glClientWaitSync", Proc(ClientWaitSync) },
+    { "glDeleteSync", Proc(DeleteSync) },
+    { "glQueryCounter", Proc(QueryCounter) },
+    { "glGetQueryiv", Proc(GetQueryiv) },
+    { "glGetQueryObjectiv", Proc(GetQueryObjectiv) },
+    { "glGetQueryObjectui64v", Proc(GetQueryObjectui64v) },
+    { "glFinish", Proc(Finish) },
+    { "glGetString", Proc(GetString) },
+    { "glGetStringi", Proc(GetStringi) },
+    { "glGetIntegerv", Proc(GetIntegerv) },
+    { "glGetError", Proc(GetError) },
+};
+
+}
+
+RecordingBackend::RecordingBackend(Mode mode)
+    : m_Mode{ mode }
+{
+    s_Current = this;
+    glad::InitGLLoader(Load);
+}
+
+RecordingBackend::~RecordingBackend()
+{
+    if (s_Current == this) s_Current = nullptr;
+}
+
+void* RecordingBackend::Load(const char* name) noexcept
+{
+    for (const auto& entry : s_EntryPoints) {
+        if (std::strcmp(entry.Name, name) == 0) return entry.Proc;
+    }
+    return nullptr;
+}
+
+void RecordingBackend::Record(const char* name, GlCallKind kind, uint32_t target, uint32_t object, uint64_t size)
+{
+    m_Counters.Calls++;
+    switch (kind) {
+    case GlCallKind::Bind: m_Counters.Binds++; break;
+    case GlCallKind::Program: m_Counters.ProgramSwitches++; break;
+    case GlCallKind::State: m_Counters.StateChanges++; break;
+    case GlCallKind::Uniform: m_Counters.UniformUpdates++; break;
+    case GlCallKind::Upload:
+        m_Counters.Uploads++;
+        m_Counters.UploadedBytes += size;
+        break;
+    case GlCallKind::Draw:
+        m_Counters.DrawCalls++;
+        m_Counters.Draws += object;
+        m_Counters.Elements += size;
+        break;
+    default: break;
+    }
+
+    if (m_Mode == Mode::Record) {
+        m_Calls.push_back(GlCall{ name, kind, target, object, size });
+    }
+}
+
+void* RecordingBackend::Scratch(size_t bytes)
+{
+    if (m_Scratch.size() < bytes) m_Scratch.resize(bytes);
+    return m_Scratch.data();
+}
+
+} // gfx
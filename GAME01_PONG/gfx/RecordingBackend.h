@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace gfx
+{
+
+enum class GlCallKind : uint8_t {
+    Bind, // buffers, textures, vertex arrays, framebuffers
+    Program, // glUseProgram
+    State, // enable/disable, blending, depth, viewport, clear color
+    Uniform,
+    Upload, // bytes sent to buffers or textures
+    Draw,
+    Clear,
+    Other // objects, shaders, queries, syncs
+};
+
+/* One entry point call. Target is the target, mode or capability of the call, Object the name it binds
+ * or the number of draws of a multi-draw, Size the bytes uploaded or the vertices/indices drawn. */
+struct GlCall {
+    const char* Name;
+    GlCallKind Kind;
+    uint32_t Target;
+    uint32_t Object;
+    uint64_t Size;
+};
+
+struct GlCounters {
+    size_t Calls{ 0 };
+    size_t DrawCalls{ 0 }; // a multi-draw is one call
+    size_t Draws{ 0 }; // a multi-draw counts all of its draws
+    size_t Elements{ 0 }; // vertices or indices drawn
+    size_t Binds{ 0 };
+    size_t ProgramSwitches{ 0 };
+    size_t StateChanges{ 0 };
+    size_t UniformUpdates{ 0 };
+    size_t Uploads{ 0 };
+    size_t UploadedBytes{ 0 };
+};
+
+/* A GL without a GPU, for running the renderer where there is no context: tests, benchmarks, CI.
+ * glad calls every entry point through a pointer, so the backend is chosen by the loader:
+ * the window loads the driver's, a RecordingBackend loads its own, which count the calls
+ * and with Mode::Record also log them. Objects get increasing names, shaders always compile,
+ * programs have no active uniforms, fences are always signaled and mapped buffers are scratch memory.
+ * Only one backend is current at a time, like a context: the last one created. */
+class RecordingBackend {
+public:
+    enum class Mode {
+        Null, // counters only
+        Record // counters and the call log
+    };
+
+    // loads glad with the recording entry points, throws glad::Error when it fails
+    explicit RecordingBackend(Mode mode = Mode::Record);
+    ~RecordingBackend();
+
+    RecordingBackend(const RecordingBackend&) = delete;
+    RecordingBackend& operator=(const RecordingBackend&) = delete;
+
+    // the loader for glad, nullptr for the entry points the renderer does not use
+    static void* Load(const char* name) noexcept;
+
+    constexpr const std::vector<GlCall>& Calls() const noexcept
+    {
+        return m_Calls;
+    }
+
+    constexpr const GlCounters& Counters() const noexcept
+    {
+        return m_Counters;
+    }
+
+    // forgets the calls and the counters, the objects stay alive
+    void Reset() noexcept
+    {
+        m_Calls.clear();
+        m_Counters = GlCounters{};
+    }
+
+    void Record(const char* name, GlCallKind kind, uint32_t target = 0, uint32_t object = 0, uint64_t size = 0);
+
+    constexpr GLuint NextName() noexcept
+    {
+        return ++m_LastName;
+    }
+
+    // scratch memory for glMapBufferRange, its content is dropped at the unmap
+    void* Scratch(size_t bytes);
+
+private:
+    Mode m_Mode;
+    std::vector<GlCall> m_Calls;
+    GlCounters m_Counters;
+    GLuint m_LastName{ 0 };
+    std::vector<std::byte> m_Scratch;
+};
+
+} // gfx
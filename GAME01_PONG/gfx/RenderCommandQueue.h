@@ -2,79 +2,182 @@
 
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <glad/glad.h>
 
-#include "Texture.h"
+#include "QuadIndexBuffer.h"
+#include "TextureRegistry.h"
 #include "SpriteStorage.h"
-#include "Shader.h"
+#include "ShaderRegistry.h"
 
 namespace gfx
 {
 
+/* First and Count are runs of consecutive sprites: the first sprite of each run in the vertex buffer
+ * of the command and the number of sprites in it. Every run is one indexed draw of quads. */
 struct RenderCommand {
-    Texture Texture;
+    TextureHandle Texture;
     GLenum Mode;
     std::vector<int> First;
     std::vector<GLsizei> Count;
     GLsizei DrawCount;
+    size_t Batch;
+    RenderPass Pass;
+    MaterialId Material{ DefaultMaterial };
 };
 
+/* Commands are grouped in batches: every batch draws from one upload of the vertex buffer,
+ * so the executor uploads a batch and then runs the commands in [BatchBegin, BatchEnd). */
 class RenderCommandQueue {
 public:
+    // IndexCounts and BaseVertices are the runs in the units of glMultiDrawElementsBaseVertex
     struct RenderCommandProxy {
         GLenum Mode;
         const int* First;
         const GLsizei* Count;
+        const GLsizei* IndexCounts;
+        const GLint* BaseVertices;
         GLsizei DrawCount;
     };
 
     constexpr void Push(const RenderCommand& command)
     {
+        m_Materials.push_back(command.Material);
         m_Textures.push_back(command.Texture);
         m_Modes.push_back(command.Mode);
         m_Firsts.insert(m_Firsts.end(), command.First.begin(), command.First.end());
         m_Counts.insert(m_Counts.end(), command.Count.begin(), command.Count.end());
+        for (GLsizei run = 0; run < command.DrawCount; ++run) {
+            m_IndexCounts.push_back(command.Count[run] * static_cast<GLsizei>(QuadIndexBuffer::IndicesPerQuad));
+            m_BaseVertices.push_back(command.First[run] * static_cast<GLint>(QuadIndexBuffer::VerticesPerQuad));
+        }
         m_DrawCounts.push_back(command.DrawCount);
+        m_Passes.push_back(command.Pass);
         m_ParameterOffsets.push_back(m_ParameterOffsets.back() + command.DrawCount);
+        if (m_BatchOffsets.size() <= command.Batch) {
+            m_BatchOffsets.resize(command.Batch + 1, m_Size);
+        }
         m_Size++;
     }
 
+    /* Appends the commands of a queue built separately for the sprites that follow the ones of this queue.
+     * Batch numbers are shared: a batch other continues keeps its offset here. */
+    constexpr void Append(const RenderCommandQueue& other)
+    {
+        size_t base = m_Size;
+        size_t parameters = m_ParameterOffsets.back();
+        m_Materials.insert(m_Materials.end(), other.m_Materials.begin(), other.m_Materials.end());
+        m_Textures.insert(m_Textures.end(), other.m_Textures.begin(), other.m_Textures.end());
+        m_Modes.insert(m_Modes.end(), other.m_Modes.begin(), other.m_Modes.end());
+        m_Firsts.insert(m_Firsts.end(), other.m_Firsts.begin(), other.m_Firsts.end());
+        m_Counts.insert(m_Counts.end(), other.m_Counts.begin(), other.m_Counts.end());
+        m_IndexCounts.insert(m_IndexCounts.end(), other.m_IndexCounts.begin(), other.m_IndexCounts.end());
+        m_BaseVertices.insert(m_BaseVertices.end(), other.m_BaseVertices.begin(), other.m_BaseVertices.end());
+        m_DrawCounts.insert(m_DrawCounts.end(), other.m_DrawCounts.begin(), other.m_DrawCounts.end());
+        m_Passes.insert(m_Passes.end(), other.m_Passes.begin(), other.m_Passes.end());
+        for (size_t i = 1; i < other.m_ParameterOffsets.size(); ++i) {
+            m_ParameterOffsets.push_back(parameters + other.m_ParameterOffsets[i]);
+        }
+        for (size_t batch = m_BatchOffsets.size(); batch < other.m_BatchOffsets.size(); ++batch) {
+            m_BatchOffsets.push_back(base + other.m_BatchOffsets[batch]);
+        }
+        m_Size += other.m_Size;
+    }
+
     constexpr size_t Size() const noexcept
     {
         return m_Size;
     }
 
+    constexpr void Clear() noexcept
+    {
+        m_Size = 0;
+        m_Materials.clear();
+        m_Textures.clear();
+        m_Modes.clear();
+        m_Firsts.clear();
+        m_Counts.clear();
+        m_IndexCounts.clear();
+        m_BaseVertices.clear();
+        m_DrawCounts.clear();
+        m_Passes.clear();
+        m_ParameterOffsets.assign(1, 0);
+        m_BatchOffsets.clear();
+    }
+
+    // a batch holds the commands of a single pass
+    constexpr RenderPass BatchPass(size_t batch) const noexcept
+    {
+        return m_Passes[m_BatchOffsets[batch]];
+    }
+
+    /* Commands ordered by pass keep each pass contiguous, returns the [begin, end) of pass. */
+    constexpr std::pair<size_t, size_t> PassRange(RenderPass pass) const noexcept
+    {
+        size_t begin = 0;
+        while (begin < m_Size && m_Passes[begin] < pass) begin++;
+        size_t end = begin;
+        while (end < m_Size && m_Passes[end] == pass) end++;
+        return { begin, end };
+    }
+
+    constexpr size_t BatchCount() const noexcept
+    {
+        return m_BatchOffsets.size();
+    }
+
+    constexpr size_t BatchBegin(size_t batch) const noexcept
+    {
+        return m_BatchOffsets[batch];
+    }
+
+    constexpr size_t BatchEnd(size_t batch) const noexcept
+    {
+        return batch + 1 < m_BatchOffsets.size() ? m_BatchOffsets[batch + 1] : m_Size;
+    }
+
     constexpr RenderCommandProxy Parameters(size_t i) const noexcept
     {
         return RenderCommandProxy{
             .Mode = m_Modes[i],
             .First = m_Firsts.data() + m_ParameterOffsets[i],
             .Count = m_Counts.data() + m_ParameterOffsets[i],
+            .IndexCounts = m_IndexCounts.data() + m_ParameterOffsets[i],
+            .BaseVertices = m_BaseVertices.data() + m_ParameterOffsets[i],
             .DrawCount = m_DrawCounts[i]
         };
     }
 
-    constexpr gfx::ShaderId Shader(size_t i) const noexcept
+    constexpr MaterialId Material(size_t i) const noexcept
     {
-        return m_ShaderIds[i];
+        return m_Materials[i];
     }
 
-    constexpr const gfx::Texture& Texture(size_t i) const noexcept
+    constexpr TextureHandle Texture(size_t i) const noexcept
     {
         return m_Textures[i];
     }
 
+    constexpr RenderPass Pass(size_t i) const noexcept
+    {
+        return m_Passes[i];
+    }
+
 private:
     size_t m_Size{ 0 };
-    std::vector<ShaderId> m_ShaderIds;
-    std::vector<gfx::Texture> m_Textures;
+    std::vector<MaterialId> m_Materials;
+    std::vector<TextureHandle> m_Textures;
     std::vector<GLenum> m_Modes;
     std::vector<int> m_Firsts; // sequential bucket of subarrays, index inside it with drawcounts.
     std::vector<GLsizei> m_Counts; // sequential bucket of subarrays, index inside it with drawcounts.
+    std::vector<GLsizei> m_IndexCounts; // same layout as m_Counts
+    std::vector<GLint> m_BaseVertices; // same layout as m_Firsts
     std::vector<GLsizei> m_DrawCounts;
+    std::vector<RenderPass> m_Passes;
     std::vector<size_t> m_ParameterOffsets{ 0 };
+    std::vector<size_t> m_BatchOffsets;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "RenderTarget.h"
+
+namespace gfx
+{
+
+RenderTarget::RenderTarget()
+    : m_Color{ Texture::Generate() },
+    m_Depth{ Texture::Generate() }
+{
+    glGenFramebuffers(1, &m_Id);
+}
+
+RenderTarget::~RenderTarget()
+{
+    glDeleteFramebuffers(1, &m_Id);
+    m_Color.Delete();
+    m_Depth.Delete();
+}
+
+bool RenderTarget::Allocate(int width, int height) noexcept
+{
+    m_Width = std::max(width, 1);
+    m_Height = std::max(height, 1);
+    m_Color.AllocateAttachment(m_Width, m_Height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    m_Depth.AllocateAttachment(m_Width, m_Height, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Id);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Color.GetId(), 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_Depth.GetId(), 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return complete;
+}
+
+void RenderTarget::Bind() const noexcept
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_Id);
+    glViewport(0, 0, m_Width, m_Height);
+}
+
+void RenderTarget::Unbind() const noexcept
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::BindRead() const noexcept
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Id);
+}
+
+void RenderTarget::BlitToScreen(int screen_width, int screen_height, Filter filter) const noexcept
+{
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_Id);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, m_Width, m_Height, 0, 0, screen_width, screen_height, GL_COLOR_BUFFER_BIT, static_cast<GLenum>(filter));
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, screen_width, screen_height);
+}
+
+} // gfx
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "Texture.h"
+
+namespace gfx
+{
+
+/* An offscreen framebuffer with a color and a depth texture.
+ * The scene is drawn into it at its own resolution and then blitted, scaled, to the window. */
+class RenderTarget {
+public:
+    enum class Filter {
+        Nearest = GL_NEAREST, // crisp pixels, for pixel art
+        Linear = GL_LINEAR,
+    };
+
+    explicit RenderTarget();
+    ~RenderTarget();
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    // (re)creates the attachments, returns false if the driver rejects the framebuffer
+    bool Allocate(int width, int height) noexcept;
+
+    // binds for drawing and sets the viewport to the whole target
+    void Bind() const noexcept;
+    void Unbind() const noexcept;
+    // as the source of reads and blits only, the draw framebuffer stays
+    void BindRead() const noexcept;
+
+    // draws the color attachment over the whole default framebuffer, which stays bound
+    void BlitToScreen(int screen_width, int screen_height, Filter filter) const noexcept;
+
+    constexpr int Width() const noexcept { return m_Width; }
+    constexpr int Height() const noexcept { return m_Height; }
+    constexpr const Texture& ColorTexture() const noexcept { return m_Color; }
+
+private:
+    unsigned int m_Id;
+    Texture m_Color;
+    Texture m_Depth;
+    int m_Width{ 0 };
+    int m_Height{ 0 };
+};
+
+/* Adaptive resolution: the scale goes down a step after a few frames over budget
+ * and back up, slowly, after many frames well under it. The hysteresis avoids oscillating
+ * between two resolutions every frame. */
+class ResolutionController {
+public:
+    constexpr static float Step = 0.85f;
+    constexpr static int SlowFramesToDrop = 3;
+    constexpr static int FastFramesToRaise = 120;
+    constexpr static float FastFraction = 0.7f;
+
+    constexpr ResolutionController(float frame_budget = 0.0f, float min_scale = 0.5f) noexcept
+        : m_Budget{ frame_budget }, m_MinScale{ min_scale }
+    {
+    }
+
+    constexpr bool Enabled() const noexcept
+    {
+        return m_Budget > 0.0f;
+    }
+
+    // returns true when the scale changed
+    constexpr bool Update(float frame_seconds) noexcept
+    {
+        if (!Enabled()) return false;
+
+        if (frame_seconds > m_Budget) {
+            m_FastFrames = 0;
+            if (++m_SlowFrames < SlowFramesToDrop || m_Scale <= m_MinScale) return false;
+            m_SlowFrames = 0;
+            m_Scale = std::max(m_MinScale, m_Scale * Step);
+            return true;
+        }
+
+        m_SlowFrames = 0;
+        if (frame_seconds > m_Budget * FastFraction) {
+            m_FastFrames = 0;
+            return false;
+        }
+        if (++m_FastFrames < FastFramesToRaise || m_Scale >= 1.0f) return false;
+        m_FastFrames = 0;
+        m_Scale = std::min(1.0f, m_Scale / Step);
+        return true;
+    }
+
+    constexpr float Scale() const noexcept
+    {
+        return m_Scale;
+    }
+
+private:
+    float m_Budget;
+    float m_MinScale;
+    float m_Scale{ 1.0f };
+    int m_SlowFrames{ 0 };
+    int m_FastFrames{ 0 };
+};
+
+} // gfx
@@ -1,13 +1,32 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
 #include <memory>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include "../Platform.h"
 #include "Texture.h"
+#include "TextureRegistry.h"
 #include "../math/math.h"
 #include "GpuHandle.h"
 #include "GpuDataConverter.h"
+#include "PrimitiveBatch.h"
+#include "RendererStats.h"
+#include "RenderTarget.h"
+#include "ShaderCache.h"
+#include "ShaderRegistry.h"
+#include "SpriteLayer.h"
 #include "SpriteStorage.h"
+#include "VertexFormat.h"
 
 namespace gfx
 {
@@ -18,95 +37,226 @@ namespace gfx
  * The internal pipeline is: User sets up the renderer state with its public interface
  * Then he calls Renderer::Flush(). From now on the flow is passed to the Graphics module.
  * The module does the following:
- * Sorts the data based on shader and texture, or just shader. Notice that when there is no texture
+ * Sorts the data based on pass, material (the shader) and texture. Notice that when there is no texture
  * We make as if there an empty one? Its just a different shader... However being 2D stuff, everything has a texture anyway.
  * The SoA that represents the sequence of things to draw can be easily managed?
  * */
 
-static const char* vertex_shader =
-"#version 330 core\n"
-"layout (location = 0) in vec3 pos;\n"
-"layout (location = 1) in vec2 uv;\n"
-"uniform mat4 projection;\n"
-"out vec2 out_uv;\n"
-"void main() {\n"
-"   gl_Position = projection * vec4(pos, 1.0);\n"
-"   out_uv = uv;\n"
-"}\n";
-
+/* The vertex shader comes with the vertex format.
+ * Variants: GRAYSCALE drops the saturation, SILHOUETTE keeps only the shape, filled with the tint. */
 static const char* fragment_shader =
 "#version 330 core\n"
 "uniform sampler2D tex;\n"
+"uniform float alpha_cutoff;\n"
 "in vec2 out_uv;\n"
+"in vec4 out_tint;\n"
 "out vec4 FragColor;\n"
 "void main() {\n"
-"   FragColor = texture(tex, out_uv);\n"
+"   vec4 texel = texture(tex, out_uv);\n"
+"#if defined(SILHOUETTE)\n"
+"   texel.rgb = vec3(1.0);\n"
+"#elif defined(GRAYSCALE)\n"
+"   texel.rgb = vec3(dot(texel.rgb, vec3(0.299, 0.587, 0.114)));\n"
+"#endif\n"
+"   vec4 color = texel * out_tint;\n"
+"   if (color.a < alpha_cutoff) discard;\n"
+"   FragColor = color;\n"
 "}\n";
 
-template <ptrdiff_t MaxSprites = 256>
+/* BatchSprites is the number of sprites uploaded to the GPU at once, not a limit:
+ * a frame with more sprites is drawn in several upload/draw batches.
+ * VertexFormat picks the vertex layout, StandardVertexFormat, CompactVertexFormat (two thirds of the upload size)
+ * or PointSpriteFormat (one record per sprite, expanded by a geometry shader). */
+template <ptrdiff_t BatchSprites = 4096, typename VertexFormat = StandardVertexFormat>
 class Renderer {
 public:
-    Renderer(glfw::Window& window)
-        : m_Window{ window },
-        m_GpuHandle{ MaxSprites * SpriteStorage<MaxSprites>::FloatsPerSprite() * sizeof(float) },
-        m_Color{ 0x000000ff },
-        m_Depth{ -static_cast<float>(MaxSprites) }
+    // automatic depths go from -DepthRange (far) towards 0 (near), one unit per sprite, or less when
+    // the frame needs more (see DepthStep). the farthest MaxLayers units are the default depths of the retained layers.
+    constexpr static float DepthRange = 65536.0f;
+    constexpr static size_t MaxLayers = 16;
+
+    using LayerId = size_t;
+    using LayerType = SpriteLayer<VertexFormat>;
+
+    // follows the size of window
+    Renderer(glfw::Window& window, TextureRegistry& textures)
+        : Renderer{ window.Size().first, window.Size().second, textures }
     {
-        auto [width, height] = window.Size();
-        m_GpuHandle.SetProjectionMatrix(math::OrthographicProjection(
-            0.0f, static_cast<float>(width),
-            0.0f, static_cast<float>(height),
-            0.0f, static_cast<float>(MaxSprites)
-        ));
         window.SizeEvent.SetHandler([this](glfw::Window& w, int width, int height) {
-            glViewport(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
-            m_GpuHandle.SetProjectionMatrix(math::OrthographicProjection(
-                0.0f, static_cast<float>(width),
-                0.0f, static_cast<float>(height),
-                0.0f, static_cast<float>(MaxSprites)
-            ));
+            Resize(width, height);
         });
     }
 
-    void Init()
+    /* Draws into whatever framebuffer is bound at Flush, of width x height pixels:
+     * no window is needed, a RecordingBackend can stand for the context. */
+    Renderer(int width, int height, TextureRegistry& textures)
+        : m_Textures{ textures },
+        m_GpuHandle{ BatchSprites * VertexFormat::VerticesPerSprite * sizeof(typename VertexFormat::Vertex), textures },
+        m_Color{ 0x000000ff }
     {
-        m_GpuHandle.Allocate();
-        m_GpuHandle.CreateShader(vertex_shader, fragment_shader);
+        SetViewSize(width, height);
     }
 
-    constexpr void DrawSprite(Sprite sprite) noexcept
+    void Resize(int width, int height) noexcept
+    {
+        glViewport(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height));
+        SetViewSize(width, height);
+        m_TargetDirty = true;
+    }
+
+    // without a cache directory the shaders are compiled at every launch
+    void Init(const std::filesystem::path& shader_cache_directory = {})
+    {
+        m_GpuHandle.template Allocate<VertexFormat>();
+        if (!shader_cache_directory.empty()) {
+            m_ShaderCache = ShaderCache{ glad::GetLoadProc(), shader_cache_directory };
+        }
+        if (CreateMaterial() != DefaultMaterial) {
+            std::cerr << "Could not build the sprite shader" << std::endl;
+            std::exit(37);
+        }
+        if (!m_Primitives.Init(m_ShaderCache.Available() ? &m_ShaderCache : nullptr, GpuHandle::FrameBlockBinding)) {
+            std::cerr << "Could not build the primitive shader, debug primitives are not drawn" << std::endl;
+        }
+    }
+
+    /* A program for Sprite::Material: the default fragment shader compiled with defines
+     * (see fragment_shader for the ones it knows), or another fragment shader reading the same inputs.
+     * Sprites are bucketed by material before texture, so every material costs at least one draw call.
+     * Returns InvalidMaterial when the program does not build, sprites using it get the default one. */
+    MaterialId CreateMaterial(
+        std::span<const std::string_view> defines = {},
+        const char* fragment_source = fragment_shader,
+        const char* vertex_source = VertexFormat::VertexShader,
+        const char* geometry_source = VertexFormat::GeometryShader)
+    {
+        auto cache = m_ShaderCache.Available() ? &m_ShaderCache : nullptr;
+        return m_GpuHandle.CreateShader(vertex_source, fragment_source, cache, defines, geometry_source);
+    }
+
+    /* Retained layers are drawn every frame, before the sprites of DrawSprite, until hidden.
+     * Their sprites without a depth go behind the immediate ones, later layers in front of earlier ones. */
+    LayerId CreateLayer(size_t capacity = 64)
+    {
+        if (m_Layers.size() >= MaxLayers) {
+            throw std::out_of_range("Renderer::CreateLayer");
+        }
+
+        float default_depth = -DepthRange + 1.0f + static_cast<float>(m_Layers.size());
+        m_Layers.push_back(std::make_unique<LayerType>(m_Textures, default_depth, capacity));
+        return m_Layers.size() - 1;
+    }
+
+    constexpr LayerType& Layer(LayerId id) noexcept
+    {
+        return *m_Layers[id];
+    }
+
+    constexpr void DrawSprite(const Sprite& sprite) noexcept
     {
         if (std::isnan(sprite.Depth)) {
-            sprite.Depth = m_Depth += 1.0f;
+            size_t first = m_Storage.Size();
+            m_Storage.AddSprite(sprite, PassOf(sprite.Texture));
+            AddAutomaticDepth(first);
+            return;
         }
 
-        m_Storage.AddSprite(sprite);
+        m_Storage.AddSprite(sprite, PassOf(sprite.Texture));
     }
 
 
-    constexpr void DrawSpritesSameDepth(std::vector<Sprite>& sprites) noexcept
+    constexpr void DrawSpritesSameDepth(std::span<const Sprite> sprites) noexcept
     {
         if (!sprites.size()) return;
 
-        m_Depth += 1.0f;
-
-        for (auto& sprite : sprites) {
-            sprite.Depth = m_Depth;
-            m_Storage.AddSprite(sprite);
+        size_t first = m_Storage.Size();
+        for (const auto& sprite : sprites) {
+            m_Storage.AddSprite(sprite, PassOf(sprite.Texture));
         }
+        AddAutomaticDepth(first);
+    }
+
+    /* Bulk submission for particles and tile layers: every column is appended with a single copy.
+     * Without depths all the sprites share one new automatic depth, like DrawSpritesSameDepth.
+     * Without uvs every sprite shows the whole texture, without tints it is not tinted.
+     * All the sprites use material. There is one sprite per position that has a size: sizes is meant to be
+     * as long as positions and the other columns empty or as long too (asserted). Without assertions
+     * the extra positions or sizes are not drawn and a shorter depths, uvs or tints is ignored. */
+    void DrawSprites(
+        std::span<const math::Vec2<float>> positions,
+        std::span<const math::Vec2<float>> sizes,
+        TextureHandle texture,
+        std::span<const float> depths = {},
+        std::span<const math::Bbox> uvs = {},
+        std::span<const math::Color> tints = {},
+        MaterialId material = DefaultMaterial)
+    {
+        assert(sizes.size() == positions.size());
+        assert(depths.empty() || depths.size() == positions.size());
+        assert(uvs.empty() || uvs.size() == positions.size());
+        assert(tints.empty() || tints.size() == positions.size());
+        const size_t count = std::min(positions.size(), sizes.size());
+        if (count == 0) return;
+
+        // the shared depth is only used when depths does not cover the sprites
+        size_t first = m_Storage.Size();
+        m_Storage.AddSprites(positions.first(count), sizes.first(count), texture, PassOf(texture), material, depths, 0.0f, uvs, tints);
+        if (depths.size() < count) AddAutomaticDepth(first);
     }
 
 
-    constexpr void DrawSprite(math::Bbox bbox, Texture texture) noexcept
+    constexpr void DrawSprite(math::Bbox bbox, TextureHandle texture) noexcept
     {
-        auto sprite = Sprite{ .Bbox = bbox, .Texture = texture, .Type = SpriteType::TexturedRect ,.Depth = m_Depth += 1.0f };
-        m_Storage.AddSprite(sprite);
+        size_t first = m_Storage.Size();
+        DrawSprite(bbox, texture, 0.0f);
+        AddAutomaticDepth(first);
     }
 
-    constexpr void DrawSprite(math::Bbox bbox, Texture texture, float depth) noexcept
+    constexpr void DrawSprite(math::Bbox bbox, TextureHandle texture, float depth) noexcept
     {
-        auto sprite = Sprite{ .Bbox = bbox, .Texture = texture, .Type = SpriteType::TexturedRect ,.Depth = depth };
-        m_Storage.AddSprite(sprite);
+        auto sprite = Sprite{ bbox, texture };
+        sprite.Depth = depth;
+        m_Storage.AddSprite(sprite, PassOf(texture));
+    }
+
+    /* Debug primitives, in world coordinates like the sprites. They are drawn over every sprite
+     * at Flush, in submission order, with one draw call per run of consecutive primitives of the same kind
+     * (triangles, lines, points). */
+    void FillRect(const math::Bbox& bbox, const math::Color& color)
+    {
+        m_Primitives.FillRect(bbox, color);
+    }
+
+    void DrawRect(const math::Bbox& bbox, const math::Color& color, float thickness = 1.0f)
+    {
+        m_Primitives.DrawRect(bbox, color, thickness);
+    }
+
+    void DrawLine(math::Vec2<float> from, math::Vec2<float> to, const math::Color& color, float thickness = 1.0f)
+    {
+        m_Primitives.DrawLine(from, to, color, thickness);
+    }
+
+    void DrawPoint(math::Vec2<float> position, const math::Color& color, float size = 1.0f)
+    {
+        m_Primitives.DrawPoint(position, color, size);
+    }
+
+    constexpr void SetCamera(math::Vec2<float> camera) noexcept
+    {
+        m_Camera = camera;
+        m_GpuHandle.SetCamera(camera);
+    }
+
+    // the area of the world covered by the projection, everything outside is culled
+    constexpr math::Bbox View() const noexcept
+    {
+        return math::Bbox{ m_Camera, m_ViewSize };
+    }
+
+    constexpr void SetTime(float time) noexcept
+    {
+        m_GpuHandle.SetTime(time);
     }
 
     constexpr void SetColor(math::Color color) noexcept
@@ -114,28 +264,295 @@ public:
         m_Color = color;
     }
 
-    constexpr void Clear() noexcept
+    /* Workers for the vertices of big frames, see GpuDataConverter::ParallelThreshold.
+     * The pool must outlive the renderer or be unset, nullptr converts on the calling thread. */
+    constexpr void SetWorkers(core::ThreadPool* pool) noexcept
     {
+        m_Workers = pool;
+    }
+
+    /* Offscreen rendering: the scene is drawn at width x height, whatever the size of the window,
+     * and stretched over the window at Flush. The view in world units does not change.
+     * A 0 size goes back to drawing straight into the window. */
+    void SetInternalResolution(int width, int height, RenderTarget::Filter filter = RenderTarget::Filter::Nearest) noexcept
+    {
+        m_InternalWidth = width;
+        m_InternalHeight = height;
+        m_ResolutionScale = 1.0f;
+        m_UpscaleFilter = filter;
+        m_TargetDirty = true;
+    }
+
+    // offscreen rendering at a fraction of the window size
+    void SetResolutionScale(float scale, RenderTarget::Filter filter = RenderTarget::Filter::Linear) noexcept
+    {
+        m_InternalWidth = 0;
+        m_InternalHeight = 0;
+        m_ResolutionScale = scale;
+        m_UpscaleFilter = filter;
+        m_TargetDirty = true;
+    }
+
+    /* Lowers the internal resolution, down to min_scale of the window, while the frames take
+     * longer than frame_budget seconds, and raises it back when they get fast. Needs ReportFrameTime. */
+    void EnableAdaptiveResolution(float frame_budget, float min_scale = 0.5f) noexcept
+    {
+        m_Adaptive = ResolutionController{ frame_budget, min_scale };
+        m_UpscaleFilter = RenderTarget::Filter::Linear;
+        m_TargetDirty = true;
+    }
+
+    /* Without presenting, frames stay in the offscreen target, at the view size unless a resolution
+     * is set, and are never blitted: for contexts without a default framebuffer, or to read them back. */
+    void SetPresent(bool present) noexcept
+    {
+        m_Present = present;
+        m_TargetDirty = true;
+    }
+
+    // what the last frame was drawn into when Offscreen()
+    constexpr const RenderTarget& Target() const noexcept
+    {
+        return m_Target;
+    }
+
+    constexpr bool Offscreen() const noexcept
+    {
+        return m_Offscreen;
+    }
+
+    /* GPU timestamps around the clear, the uploads and every command, read back a few frames late
+     * into Stats().Gpu, see GpuTimer. Off by default: the queries cost a little on every frame. */
+    void EnableGpuTiming(bool enabled) noexcept
+    {
+        m_GpuHandle.Timer().SetEnabled(enabled);
+    }
+
+    // the GPU time of each command of the frame Stats().Gpu is about, in the order they ran
+    std::span<const double> GpuCommandMs() const noexcept
+    {
+        return m_GpuHandle.Timer().CommandMs();
+    }
+
+    // the time the last frame took to produce, present included
+    void ReportFrameTime(float seconds) noexcept
+    {
+        if (m_Adaptive.Update(seconds)) {
+            m_TargetDirty = true;
+        }
+    }
+
+    void Clear() noexcept
+    {
+        // the frame of the GPU timer starts at the clear, or at the flush without one
+        m_GpuHandle.Timer().BeginFrame();
+        BeginTarget();
         m_GpuHandle.Clear(m_Color);
     }
 
     constexpr void Flush()
     {
-        auto converter = std::make_unique<GpuDataConverter<MaxSprites>>(m_Storage);
-        m_GpuHandle.UploadVertexData(converter->VertexData());
-        m_GpuHandle.UploadCommandData(converter->DrawingData());
+        using clock = std::chrono::steady_clock;
+        auto& timer = m_GpuHandle.Timer();
+        if (!timer.Recording()) timer.BeginFrame();
+
+        BeginTarget();
+        AssignAutomaticDepths();
+        const auto view = View();
+        const auto submitted = m_Storage.Size();
+        const auto culled = m_Storage.Cull(view);
+
+        // the immediate sprites are all in view, their positions are written relative to its corner
+        auto convert_start = clock::now();
+        auto converter = std::make_unique<GpuDataConverter<BatchSprites, VertexFormat>>(m_Storage, view.Pos, m_Workers);
+        const auto& queue = converter->DrawingData();
+        auto submit_start = clock::now();
+        const double convert_ms = std::chrono::duration<double, std::milli>(submit_start - convert_start).count();
+
+        // the other counters are added up below
+        m_Stats = RendererStats{};
+        m_Stats.Sprites = submitted;
+        m_Stats.Culled = culled;
+        m_Stats.Drawn = m_Storage.Size();
+        m_Stats.Buckets = converter->Buckets();
+        m_Stats.Batches = queue.BatchCount();
+        m_Stats.DrawCalls = queue.Size();
+        m_Stats.ConvertTasks = converter->Tasks();
+        m_Stats.Textures = m_Textures.Size();
+        m_Stats.TextureBytes = m_Textures.GpuBytes() + m_Textures.PendingBytes();
+        m_Stats.ShaderCacheHits = m_ShaderCache.Hits();
+        m_Stats.ShaderCacheMisses = m_ShaderCache.Misses();
+        m_Stats.ShaderBuildMs = m_ShaderCache.BuildMs();
+        m_Stats.SortMs = converter->SortMs();
+        m_Stats.ConvertMs = convert_ms - converter->SortMs();
+
+        m_GpuHandle.UploadFrameData();
+        timer.Mark(GpuSection::Other);
+        for (const auto& layer : m_Layers) {
+            if (!layer->Visible()) continue;
+
+            m_Stats.RetainedUploads += layer->Sync(view);
+            m_Stats.UploadedBytes += layer->TakeUploadedBytes();
+            m_Stats.RetainedSprites += layer->Size();
+            m_Stats.Culled += layer->Size() - layer->VisibleCount();
+            m_Stats.Drawn += layer->VisibleCount();
+            m_Stats.DrawCalls += layer->Commands().Size();
+        }
+        timer.Mark(GpuSection::Upload);
+
+        // in each pass the retained layers go first, they are the backgrounds
+        size_t batch = 0;
+        for (auto pass : { RenderPass::Opaque, RenderPass::Translucent }) {
+            m_GpuHandle.SetPass(pass);
+            for (const auto& layer : m_Layers) {
+                if (!layer->Visible()) continue;
+
+                auto [begin, end] = layer->Commands().PassRange(pass);
+                m_GpuHandle.ExecuteCommands(layer->VertexArray(), layer->Commands(), begin, end);
+            }
+
+            for (; batch < queue.BatchCount() && queue.BatchPass(batch) == pass; ++batch) {
+                m_GpuHandle.UploadVertexData(converter->VertexData(batch));
+                m_GpuHandle.UploadCommandData(queue, queue.BatchBegin(batch), queue.BatchEnd(batch), converter->Origin());
+            }
+        }
+        m_Stats.Primitives = m_Primitives.Size();
+        const size_t primitive_draws = m_Primitives.Flush();
+        m_Stats.DrawCalls += primitive_draws;
+        timer.Mark(GpuSection::Primitives);
+        m_Stats.ProgramSwitches = m_GpuHandle.TakeProgramSwitches() + (primitive_draws ? 1 : 0);
+        m_Stats.TextureBinds = m_GpuHandle.TakeTextureBinds();
+        m_Stats.UploadedBytes += m_GpuHandle.TakeUploadedBytes() + m_Primitives.TakeUploadedBytes();
         m_GpuHandle.Free();
         m_Storage.Clear();
-        m_Depth = -static_cast<float>(MaxSprites);
+        m_Stats.SaturatedDepths = std::exchange(m_SaturatedDepths, 0);
+        m_AutomaticDepths.clear();
+        m_Textures.CollectGarbage();
+
+        if (m_Offscreen && m_Present) {
+            m_Target.BlitToScreen(static_cast<int>(m_ViewSize.x()), static_cast<int>(m_ViewSize.y()), m_UpscaleFilter);
+            timer.Mark(GpuSection::Present);
+        }
+        timer.EndFrame();
+        m_Stats.Gpu = timer.Last();
+        m_Stats.SubmitMs = std::chrono::duration<double, std::milli>(clock::now() - submit_start).count();
+    }
+
+    constexpr TextureRegistry& Textures() noexcept
+    {
+        return m_Textures;
+    }
+
+    constexpr const RendererStats& Stats() const noexcept
+    {
+        return m_Stats;
     }
 
 private:
-    const glfw::Window& m_Window;
+    // the sprites [First, Last) of the storage, in submission order
+    struct AutomaticDepth {
+        size_t First;
+        size_t Last;
+    };
+
+    // binds the offscreen target when one is used, resizing it first if its resolution changed
+    void BeginTarget() noexcept
+    {
+        if (m_TargetDirty) {
+            m_TargetDirty = false;
+            float scale = m_ResolutionScale * m_Adaptive.Scale();
+            int width = m_InternalWidth > 0 ? m_InternalWidth : static_cast<int>(m_ViewSize.x() * scale);
+            int height = m_InternalHeight > 0 ? m_InternalHeight : static_cast<int>(m_ViewSize.y() * scale);
+            bool native = m_Present && m_InternalWidth <= 0 && scale == 1.0f && !m_Adaptive.Enabled();
+            m_Offscreen = !native && m_Target.Allocate(width, height);
+            if (!m_Offscreen) {
+                m_Target.Unbind();
+                glViewport(0, 0, static_cast<GLsizei>(m_ViewSize.x()), static_cast<GLsizei>(m_ViewSize.y()));
+            }
+        }
+
+        if (m_Offscreen) {
+            m_Target.Bind();
+        }
+    }
+
+    void SetViewSize(int width, int height) noexcept
+    {
+        m_ViewSize = { static_cast<float>(width), static_cast<float>(height) };
+        m_GpuHandle.SetProjectionMatrix(math::OrthographicProjection(
+            0.0f, static_cast<float>(width),
+            0.0f, static_cast<float>(height),
+            0.0f, DepthRange
+        ));
+    }
+
+    // immediate sprites borrow their texture until Flush, the caller keeps it alive
+    constexpr RenderPass PassOf(TextureHandle texture) const noexcept
+    {
+        assert(texture == InvalidTexture || m_Textures.Valid(texture));
+        return gfx::PassOf(m_Textures.Alpha(texture));
+    }
+
+    constexpr static float FirstImmediateDepth() noexcept
+    {
+        return -DepthRange + static_cast<float>(MaxLayers);
+    }
+
+    // the sprites added since first share the next automatic depth, the value is set at Flush
+    constexpr void AddAutomaticDepth(size_t first) noexcept
+    {
+        m_AutomaticDepths.push_back(AutomaticDepth{ first, m_Storage.Size() });
+    }
+
+    /* Once the frame is submitted its automatic depths are known: they get the step fitting all of them,
+     * in submission order. Past the near plane every sprite gets the same depth, the later ones lose the depth test. */
+    constexpr void AssignAutomaticDepths() noexcept
+    {
+        const float step = DepthStep(m_AutomaticDepths.size());
+        float depth = FirstImmediateDepth();
+        for (const auto& automatic : m_AutomaticDepths) {
+            if (depth >= 0.0f) {
+                m_SaturatedDepths++;
+            }
+            depth = std::min(depth + step, 0.0f);
+            m_Storage.SetDepth(automatic.First, automatic.Last, depth);
+        }
+    }
+
+    /* The largest step fitting count automatic depths in the range, halved from 1 down to the resolution
+     * of the vertex format: powers of two keep the sums exact. A frame needing more than that saturates. */
+    constexpr static float DepthStep(size_t count) noexcept
+    {
+        float step = 1.0f;
+        while (step > VertexFormat::DepthResolution && static_cast<float>(count) * step > -FirstImmediateDepth()) {
+            step /= 2.0f;
+        }
+        return step;
+    }
+
+    TextureRegistry& m_Textures;
     GpuHandle m_GpuHandle;
     math::Color m_Color;
-    math::Mat<float, 4, 4> m_Projection;
-    SpriteStorage<MaxSprites> m_Storage;
-    float m_Depth;
+    SpriteStorage<BatchSprites> m_Storage;
+    PrimitiveBatch m_Primitives;
+    std::vector<std::unique_ptr<LayerType>> m_Layers;
+    math::Vec2<float> m_Camera;
+    math::Vec2<float> m_ViewSize;
+    RendererStats m_Stats;
+    std::vector<AutomaticDepth> m_AutomaticDepths;
+    size_t m_SaturatedDepths{ 0 };
+    core::ThreadPool* m_Workers{ nullptr };
+
+    ShaderCache m_ShaderCache;
+    RenderTarget m_Target;
+    ResolutionController m_Adaptive;
+    RenderTarget::Filter m_UpscaleFilter{ RenderTarget::Filter::Nearest };
+    int m_InternalWidth{ 0 };
+    int m_InternalHeight{ 0 };
+    float m_ResolutionScale{ 1.0f };
+    bool m_Offscreen{ false };
+    bool m_Present{ true };
+    bool m_TargetDirty{ false };
 };
 
 
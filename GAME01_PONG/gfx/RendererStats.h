@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+namespace gfx
+{
+
+/* GPU time of the parts of a frame, measured by a GpuTimer. It arrives a few frames late,
+ * Frame says which frame it belongs to. The parts add up to TotalMs. */
+struct GpuTimings {
+    size_t Frame{ 0 }; // counted from 1, 0 until a frame has been read back
+    double ClearMs{ 0.0 };
+    double UploadMs{ 0.0 }; // vertex buffers, immediate and retained
+    double DrawMs{ 0.0 }; // the commands of the sprites, retained layers included
+    double PrimitivesMs{ 0.0 };
+    double PresentMs{ 0.0 }; // the blit of the offscreen target
+    double OtherMs{ 0.0 }; // between the clear and the flush, and the frame setup of the flush
+    double TotalMs{ 0.0 };
+};
+
+/* Counters of the last flushed frame. */
+struct RendererStats {
+    size_t Sprites{ 0 };
+    size_t Culled{ 0 };
+    size_t Drawn{ 0 };
+    size_t Buckets{ 0 }; // runs of sprites sharing pass, material and texture
+    size_t Batches{ 0 };
+    size_t DrawCalls{ 0 };
+    size_t ProgramSwitches{ 0 };
+    size_t TextureBinds{ 0 }; // only the ones changing the texture
+    size_t UploadedBytes{ 0 }; // buffer data: vertices of the sprites, immediate and retained, and of the primitives, frame uniforms
+    size_t ConvertTasks{ 0 }; // 0 when the vertices were written on the calling thread
+    size_t RetainedSprites{ 0 };
+    size_t RetainedUploads{ 0 };
+    size_t Primitives{ 0 };
+    size_t SaturatedDepths{ 0 }; // automatic depths past the near plane, they all got depth 0
+    size_t Textures{ 0 };
+    size_t TextureBytes{ 0 }; // released textures still waiting for the GPU included
+    // programs built through the shader cache since Init, not only this frame; 0 without a cache (no directory, or no program binaries)
+    size_t ShaderCacheHits{ 0 };
+    size_t ShaderCacheMisses{ 0 };
+
+    // CPU time of Flush: sorting the sprites, writing the vertices and commands, issuing the GL calls
+    double SortMs{ 0.0 };
+    double ConvertMs{ 0.0 };
+    double SubmitMs{ 0.0 };
+    double ShaderBuildMs{ 0.0 }; // of the programs counted by ShaderCacheHits and ShaderCacheMisses
+
+    // of an earlier frame, all 0 without Renderer::EnableGpuTiming
+    GpuTimings Gpu;
+};
+
+}
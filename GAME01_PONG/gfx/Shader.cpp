@@ -1,7 +1,9 @@
 #include "Shader.h"
 
+#include <algorithm>
 #include <array>
 #include <iostream>
+#include <optional>
 #include <string_view>
 
 #include <glad/glad.h>
@@ -24,6 +26,19 @@ static bool CheckShaderOperationResult(unsigned int id, GLenum what, const char*
     return success;
 }
 
+static bool CheckProgramOperationResult(unsigned int id, GLenum what, const char* who)
+{
+    int success;
+    char info_log[512];
+    glGetProgramiv(id, what, &success);
+    if (!success) {
+        glGetProgramInfoLog(id, 512, nullptr, info_log);
+        std::cout << "ERROR: " << who << " failed : \n" << info_log << std::endl;
+    };
+
+    return success;
+}
+
 
 Shader::Shader(std::string_view source, Type type) : m_Id{ glCreateShader(static_cast<GLenum>(type)) }, m_Source(source) {}
 Shader::~Shader() { glDeleteShader(m_Id); }
@@ -45,10 +60,12 @@ bool Shader::Compile() const noexcept
 
 ShaderProgram::ShaderProgram(
     const char* vertex_shader_source,
-    const char* fragment_shader_source
+    const char* fragment_shader_source,
+    const char* geometry_shader_source
 ) : m_Id{ glCreateProgram() },
 m_VertexShaderSource{ vertex_shader_source },
-m_FragmentShaderSource{ fragment_shader_source }
+m_FragmentShaderSource{ fragment_shader_source },
+m_GeometryShaderSource{ geometry_shader_source ? geometry_shader_source : "" }
 {
 }
 
@@ -58,12 +75,82 @@ bool ShaderProgram::Build() noexcept
     if (!vertex_shader.Compile()) return false;
     glAttachShader(m_Id, vertex_shader.GetId());
 
+    // declared here so that it lives until the link
+    std::optional<Shader> geometry_shader;
+    if (!m_GeometryShaderSource.empty()) {
+        geometry_shader.emplace(m_GeometryShaderSource, Shader::Type::Geometry);
+        if (!geometry_shader->Compile()) return false;
+        glAttachShader(m_Id, geometry_shader->GetId());
+    }
+
     Shader fragment_shader{ m_FragmentShaderSource, Shader::Type::Fragment };
     if (!fragment_shader.Compile()) return false;
     glAttachShader(m_Id, fragment_shader.GetId());
 
     glLinkProgram(m_Id);
-    return CheckShaderOperationResult(m_Id, GL_LINK_STATUS, "Linking");
+    if (!CheckProgramOperationResult(m_Id, GL_LINK_STATUS, "Linking")) return false;
+
+    Reflect();
+    return true;
+}
+
+void ShaderProgram::Reflect()
+{
+    m_Uniforms.clear();
+    m_UniformBlocks.clear();
+
+    GLint uniform_count = 0;
+    GLint max_name_length = 0;
+    glGetProgramiv(m_Id, GL_ACTIVE_UNIFORMS, &uniform_count);
+    glGetProgramiv(m_Id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+
+    std::string name(static_cast<size_t>(std::max(max_name_length, 1)), '\0');
+    for (GLint i = 0; i < uniform_count; ++i) {
+        GLsizei length = 0;
+        GLint count = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_Id, static_cast<GLuint>(i), max_name_length, &length, &count, &type, name.data());
+
+        // members of uniform blocks have no location, they are reached through the block
+        auto location = glGetUniformLocation(m_Id, name.c_str());
+        if (location < 0) continue;
+
+        std::string_view uniform_name{ name.data(), static_cast<size_t>(length) };
+        if (uniform_name.ends_with("[0]")) uniform_name.remove_suffix(3);
+        m_Uniforms.push_back({ std::string{ uniform_name }, location, type, count });
+    }
+
+    GLint block_count = 0;
+    glGetProgramiv(m_Id, GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+    glGetProgramiv(m_Id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_name_length);
+
+    name.assign(static_cast<size_t>(std::max(max_name_length, 1)), '\0');
+    for (GLint i = 0; i < block_count; ++i) {
+        GLsizei length = 0;
+        GLint data_size = 0;
+        glGetActiveUniformBlockName(m_Id, static_cast<GLuint>(i), max_name_length, &length, name.data());
+        glGetActiveUniformBlockiv(m_Id, static_cast<GLuint>(i), GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+        m_UniformBlocks.push_back({ std::string{ name.data(), static_cast<size_t>(length) }, static_cast<GLuint>(i), data_size });
+    }
+}
+
+UniformHandle ShaderProgram::Uniform(std::string_view uniform_name) const noexcept
+{
+    for (const auto& uniform : m_Uniforms) {
+        if (uniform.Name == uniform_name) return uniform.Location;
+    }
+    return -1;
+}
+
+bool ShaderProgram::BindUniformBlock(std::string_view block_name, GLuint binding) const noexcept
+{
+    for (const auto& block : m_UniformBlocks) {
+        if (block.Name == block_name) {
+            glUniformBlockBinding(m_Id, block.Index, binding);
+            return true;
+        }
+    }
+    return false;
 }
 
 void ShaderProgram::Use() const noexcept
@@ -71,97 +158,99 @@ void ShaderProgram::Use() const noexcept
     glUseProgram(m_Id);
 }
 
-ShaderProgram::ShaderUniform::ShaderUniform(unsigned int program_id, std::string_view uniform_name)
-    : m_ProgId(program_id), m_UniformName(uniform_name)
+ShaderProgram::ShaderUniform::ShaderUniform(UniformHandle location)
+    : m_Location(location)
 {
 }
 
-void ShaderProgram::ShaderUniform::operator=(bool value) noexcept { glUniform1i(Location(), (int)value); }
-void ShaderProgram::ShaderUniform::operator=(float value) noexcept { glUniform1f(Location(), value); }
-void ShaderProgram::ShaderUniform::operator=(int value) noexcept { glUniform1i(Location(), value); }
+void ShaderProgram::ShaderUniform::operator=(bool value) noexcept { glUniform1i(m_Location, (int)value); }
+void ShaderProgram::ShaderUniform::operator=(float value) noexcept { glUniform1f(m_Location, value); }
+void ShaderProgram::ShaderUniform::operator=(int value) noexcept { glUniform1i(m_Location, value); }
 
 void ShaderProgram::ShaderUniform::operator=(math::Mat<float, 4, 4>&& value) noexcept
 {
-    glUniformMatrix4fv(Location(), 1, GL_FALSE, value.Ptr());
+    glUniformMatrix4fv(m_Location, 1, GL_FALSE, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(const math::Mat<float, 4, 4>& value) noexcept
 {
-    glUniformMatrix4fv(Location(), 1, GL_FALSE, value.Ptr());
+    glUniformMatrix4fv(m_Location, 1, GL_FALSE, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(math::Vec<float, 4>&& value) noexcept
 {
-    glUniform4fv(Location(), 1, value.Ptr());
+    glUniform4fv(m_Location, 1, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(const math::Vec<float, 4>& value) noexcept
 {
-    glUniform4fv(Location(), 1, value.Ptr());
+    glUniform4fv(m_Location, 1, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(math::Vec<float, 3>&& value) noexcept
 {
-    glUniform3fv(Location(), 1, value.Ptr());
+    glUniform3fv(m_Location, 1, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(const math::Vec<float, 3>& value) noexcept
 {
-    glUniform3fv(Location(), 1, value.Ptr());
+    glUniform3fv(m_Location, 1, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(math::Vec<float, 2>&& value) noexcept
 {
-    glUniform2fv(Location(), 1, value.Ptr());
+    glUniform2fv(m_Location, 1, value.Ptr());
 }
 
 void ShaderProgram::ShaderUniform::operator=(const math::Vec<float, 2>& value) noexcept
 {
-    glUniform2fv(Location(), 1, value.Ptr());
-}
-constexpr int ShaderProgram::ShaderUniform::Location() const noexcept
-{
-    return glGetUniformLocation(m_ProgId, m_UniformName.data());
+    glUniform2fv(m_Location, 1, value.Ptr());
 }
-ShaderProgram::ConstShaderUniform::ConstShaderUniform(unsigned int program_id, std::string_view uniform_name)
-    : m_ProgId(program_id), m_UniformName(uniform_name)
+
+ShaderProgram::ConstShaderUniform::ConstShaderUniform(unsigned int program_id, UniformHandle location)
+    : m_ProgId(program_id), m_Location(location)
 {
 }
 
 ShaderProgram::ConstShaderUniform::operator bool() const noexcept
 {
     bool value{};
-    glGetUniformiv(m_ProgId, Location(), (int*)&value);
+    glGetUniformiv(m_ProgId, m_Location, (int*)&value);
     return value;
 }
 
 ShaderProgram::ConstShaderUniform::operator float() const noexcept
 {
     float value{};
-    glGetUniformfv(m_ProgId, Location(), &value);
+    glGetUniformfv(m_ProgId, m_Location, &value);
     return value;
 }
 
 ShaderProgram::ConstShaderUniform::operator int() const noexcept
 {
     int value{};
-    glGetUniformiv(m_ProgId, Location(), &value);
+    glGetUniformiv(m_ProgId, m_Location, &value);
     return value;
 }
 
-constexpr int ShaderProgram::ConstShaderUniform::Location() const noexcept
+ShaderProgram::ShaderUniform ShaderProgram::operator[](std::string_view uniform_name) noexcept
 {
-    return glGetUniformLocation(m_ProgId, m_UniformName.data());
+    return ShaderUniform{ Uniform(uniform_name) };
 }
 
-ShaderProgram::ShaderUniform ShaderProgram::operator[](std::string_view uniform_name) noexcept
+ShaderProgram::ShaderUniform ShaderProgram::operator[](UniformHandle location) noexcept
 {
-    return ShaderUniform{ m_Id, uniform_name };
+    return ShaderUniform{ location };
 }
 
 ShaderProgram::ConstShaderUniform ShaderProgram::operator[](std::string_view uniform_name) const noexcept
 {
-    return ConstShaderUniform{ m_Id, uniform_name };
+    return ConstShaderUniform{ m_Id, Uniform(uniform_name) };
+}
+
+ShaderProgram::ConstShaderUniform ShaderProgram::operator[](UniformHandle location) const noexcept
+{
+    return ConstShaderUniform{ m_Id, location };
 }
 
 }
@@ -4,7 +4,9 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <string>
 #include <string_view>
+#include <vector>
 
 #include <glad/glad.h>
 
@@ -14,6 +16,7 @@ namespace gfx
 {
 
 using ShaderId = unsigned int;
+using UniformHandle = int;
 
 class Shader {
 public:
@@ -33,17 +36,41 @@ private:
 };
 
 
+class ShaderCache;
+
 class ShaderProgram {
 
 public:
+    /* filled by reflection right after linking, so that names are resolved once
+     * and the draw loop only deals with integer handles. */
+    struct UniformInfo {
+        std::string Name;
+        UniformHandle Location;
+        GLenum Type;
+        GLint Count;
+    };
+
+    struct UniformBlockInfo {
+        std::string Name;
+        GLuint Index;
+        GLint DataSize;
+    };
+
     ShaderProgram() = default;
-    ShaderProgram(const char* vertex_shader_source, const char* fragment_shader_source);
+    // the geometry stage is optional
+    ShaderProgram(const char* vertex_shader_source, const char* fragment_shader_source, const char* geometry_shader_source = nullptr);
     constexpr unsigned int Id() const noexcept { return m_Id; }
     bool Build() noexcept;
     void Use() const noexcept;
+
+    UniformHandle Uniform(std::string_view uniform_name) const noexcept;
+    bool BindUniformBlock(std::string_view block_name, GLuint binding) const noexcept;
+    const std::vector<UniformInfo>& Uniforms() const noexcept { return m_Uniforms; }
+    const std::vector<UniformBlockInfo>& UniformBlocks() const noexcept { return m_UniformBlocks; }
+
     class ShaderUniform {
     public:
-        ShaderUniform(unsigned int program_id, std::string_view uniform_name);
+        ShaderUniform(UniformHandle location);
         void operator=(bool value) noexcept;
         void operator=(float value) noexcept;
         void operator=(int value) noexcept;
@@ -56,30 +83,36 @@ public:
         void operator=(math::Vec<float, 2>&& value) noexcept;
         void operator=(const math::Vec<float, 2>& value) noexcept;
     private:
-        constexpr int Location() const noexcept;
-        unsigned int m_ProgId;
-        std::string_view m_UniformName;
+        UniformHandle m_Location;
     };
 
     class ConstShaderUniform {
     public:
-        ConstShaderUniform(unsigned int program_id, std::string_view uniform_name);
+        ConstShaderUniform(unsigned int program_id, UniformHandle location);
         operator bool() const noexcept;
         operator float() const noexcept;
         operator int() const noexcept;
 
     private:
-        constexpr int Location() const noexcept;
         unsigned int m_ProgId;
-        std::string_view m_UniformName;
+        UniformHandle m_Location;
     };
 
     ShaderUniform operator[](std::string_view uniform_name) noexcept;
+    ShaderUniform operator[](UniformHandle location) noexcept;
 
     ConstShaderUniform operator[](std::string_view uniform_name) const noexcept;
+    ConstShaderUniform operator[](UniformHandle location) const noexcept;
 
 private:
+    // the cache links programs from binaries and reads back the sources to hash them
+    friend class ShaderCache;
+
+    void Reflect();
+
     unsigned int m_Id{};
+    std::vector<UniformInfo> m_Uniforms;
+    std::vector<UniformBlockInfo> m_UniformBlocks;
     std::string_view m_VertexShaderSource;
     std::string_view m_FragmentShaderSource;
     std::string_view m_GeometryShaderSource;
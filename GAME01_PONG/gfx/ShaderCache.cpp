@@ -0,0 +1,180 @@
+#include "ShaderCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace gfx
+{
+
+/* File layout: magic, binary format, binary size, binary. */
+constexpr uint32_t CacheFileMagic = 0x43485347; // "GSHC"
+
+static uint64_t Fnv1a(uint64_t hash, std::string_view data) noexcept
+{
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    // a separator, so that moving text between two fields changes the hash
+    hash ^= 0xff;
+    hash *= 0x100000001b3ull;
+    return hash;
+}
+
+static std::string_view GlString(GLenum name) noexcept
+{
+    auto str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? std::string_view{ str } : std::string_view{};
+}
+
+ShaderCache::ShaderCache(LoadProc load_proc, std::filesystem::path directory)
+    : m_Directory{ std::move(directory) }
+{
+    if (!load_proc) return;
+
+    // a GL without program binaries rejects the name and leaves the count at 0, glGetError is not needed
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (format_count <= 0) return;
+
+    m_GetProgramBinary = reinterpret_cast<GetProgramBinaryFn>(load_proc("glGetProgramBinary"));
+    m_ProgramBinary = reinterpret_cast<ProgramBinaryFn>(load_proc("glProgramBinary"));
+    m_ProgramParameteri = reinterpret_cast<ProgramParameteriFn>(load_proc("glProgramParameteri"));
+
+    m_DriverId.append(GlString(GL_VENDOR)).append("\n");
+    m_DriverId.append(GlString(GL_RENDERER)).append("\n");
+    m_DriverId.append(GlString(GL_VERSION)).append("\n");
+    m_DriverId.append(GlString(GL_SHADING_LANGUAGE_VERSION));
+
+    std::error_code error;
+    std::filesystem::create_directories(m_Directory, error);
+}
+
+std::filesystem::path ShaderCache::DefaultDirectory(std::string_view app_name)
+{
+    std::filesystem::path base;
+#ifdef _WIN32
+    if (auto local = std::getenv("LOCALAPPDATA")) base = local;
+#else
+    if (auto xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        base = xdg;
+    } else if (auto home = std::getenv("HOME")) {
+        base = std::filesystem::path{ home } / ".cache";
+    }
+#endif
+    if (base.empty()) base = std::filesystem::temp_directory_path();
+    return base / app_name / "shaders";
+}
+
+bool ShaderCache::Build(ShaderProgram& program, std::string_view defines)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto add_time = [this, &start]() {
+        m_BuildMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    if (!Available()) {
+        bool built = program.Build();
+        m_Misses++;
+        add_time();
+        return built;
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(Key(program, defines)));
+    auto path = m_Directory / name;
+
+    if (Load(program, path)) {
+        m_Hits++;
+        add_time();
+        return true;
+    }
+
+    m_ProgramParameteri(program.Id(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    bool built = program.Build();
+    m_Misses++;
+    if (built) Store(program, path);
+    add_time();
+    return built;
+}
+
+uint64_t ShaderCache::Key(const ShaderProgram& program, std::string_view defines) const noexcept
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = Fnv1a(hash, program.m_VertexShaderSource);
+    hash = Fnv1a(hash, program.m_GeometryShaderSource);
+    hash = Fnv1a(hash, program.m_FragmentShaderSource);
+    hash = Fnv1a(hash, defines);
+    hash = Fnv1a(hash, m_DriverId);
+    return hash;
+}
+
+bool ShaderCache::Load(ShaderProgram& program, const std::filesystem::path& path) const
+{
+    std::ifstream file{ path, std::ios::binary };
+    if (!file) return false;
+
+    uint32_t header[3]{};
+    file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!file || header[0] != CacheFileMagic || header[2] == 0) return false;
+
+    std::vector<char> binary(header[2]);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!file) return false;
+
+    m_ProgramBinary(program.Id(), static_cast<GLenum>(header[1]), binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program.Id(), GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // stale binary, from a driver that does not accept it anymore
+        return false;
+    }
+
+    program.Reflect();
+    return true;
+}
+
+void ShaderCache::Store(const ShaderProgram& program, const std::filesystem::path& path) const
+{
+    GLint length = 0;
+    glGetProgramiv(program.Id(), GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    m_GetProgramBinary(program.Id(), length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    // written aside and renamed, so a crash never leaves a truncated entry
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file{ temporary, std::ios::binary | std::ios::trunc };
+        if (!file) return;
+
+        uint32_t header[3]{ CacheFileMagic, static_cast<uint32_t>(format), static_cast<uint32_t>(written) };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+}
+
+} // gfx
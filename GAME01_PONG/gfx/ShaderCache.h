@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include <glad/glad.h>
+
+#include "Shader.h"
+
+namespace gfx
+{
+
+/* Keeps linked programs on disk with glGetProgramBinary, so a launch after the first one
+ * skips compiling and linking. A binary is keyed by a hash of the sources, the defines and
+ * the GL vendor, renderer and version strings: a driver update gets new entries
+ * and a driver refusing an old binary just falls back to compiling.
+ * Program binaries are GL 4.1 (or ARB_get_program_binary), their entry points are
+ * loaded here; without them Build always compiles. */
+class ShaderCache {
+public:
+    using LoadProc = void* (*)(const char* name);
+
+    ShaderCache() = default;
+    ShaderCache(LoadProc load_proc, std::filesystem::path directory);
+
+    // $XDG_CACHE_HOME/<app>/shaders, ~/.cache/<app>/shaders or %LOCALAPPDATA%/<app>/shaders
+    static std::filesystem::path DefaultDirectory(std::string_view app_name);
+
+    // links program from the cache or by compiling it, then stores the result
+    bool Build(ShaderProgram& program, std::string_view defines = {});
+
+    constexpr bool Available() const noexcept { return m_GetProgramBinary && m_ProgramBinary && m_ProgramParameteri; }
+    // programs linked from a stored binary, compiled, and the time Build took for all of them; see RendererStats
+    constexpr size_t Hits() const noexcept { return m_Hits; }
+    constexpr size_t Misses() const noexcept { return m_Misses; }
+    constexpr double BuildMs() const noexcept { return m_BuildMs; }
+
+private:
+    using GetProgramBinaryFn = void (APIENTRY*)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    using ProgramBinaryFn = void (APIENTRY*)(GLuint, GLenum, const void*, GLsizei);
+    using ProgramParameteriFn = void (APIENTRY*)(GLuint, GLenum, GLint);
+
+    uint64_t Key(const ShaderProgram& program, std::string_view defines) const noexcept;
+    bool Load(ShaderProgram& program, const std::filesystem::path& path) const;
+    void Store(const ShaderProgram& program, const std::filesystem::path& path) const;
+
+    GetProgramBinaryFn m_GetProgramBinary{ nullptr };
+    ProgramBinaryFn m_ProgramBinary{ nullptr };
+    ProgramParameteriFn m_ProgramParameteri{ nullptr };
+    std::filesystem::path m_Directory;
+    std::string m_DriverId;
+    size_t m_Hits{ 0 };
+    size_t m_Misses{ 0 };
+    double m_BuildMs{ 0.0 };
+};
+
+} // gfx
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../math/math.h"
+#include "Shader.h"
+#include "ShaderCache.h"
+
+namespace gfx
+{
+
+/* Index of a program of the ShaderRegistry, what sprites carry to pick their shader.
+ * Material 0 is the first program created, the default one. */
+using MaterialId = uint16_t;
+
+constexpr MaterialId DefaultMaterial = 0;
+constexpr MaterialId InvalidMaterial = 0xffff;
+
+/* Every program the renderer draws with. A variant is a set of sources compiled with some defines,
+ * inserted right after the #version line, so one source gives several programs (effects)
+ * that all read the same vertex layout and uniforms.
+ * The uniforms set by the executor are resolved once per program when it is created. */
+class ShaderRegistry {
+public:
+    ShaderRegistry() = default;
+    ShaderRegistry(const ShaderRegistry&) = delete;
+    ShaderRegistry& operator=(const ShaderRegistry&) = delete;
+
+    /* Returns InvalidMaterial when the program does not build.
+     * The sources are copied, they do not need to outlive the call. */
+    MaterialId Create(
+        std::string_view vertex_shader_source,
+        std::string_view fragment_shader_source,
+        std::string_view geometry_shader_source = {},
+        std::span<const std::string_view> defines = {},
+        ShaderCache* cache = nullptr,
+        GLuint frame_block_binding = 0)
+    {
+        if (m_Programs.size() >= InvalidMaterial) return InvalidMaterial;
+
+        std::string define_block;
+        for (auto define : defines) {
+            define_block += "#define ";
+            define_block += define;
+            define_block += '\n';
+        }
+
+        auto entry = std::make_unique<Entry>();
+        entry->VertexSource = WithDefines(vertex_shader_source, define_block);
+        entry->FragmentSource = WithDefines(fragment_shader_source, define_block);
+        entry->GeometrySource = geometry_shader_source.empty() ? std::string{} : WithDefines(geometry_shader_source, define_block);
+        entry->Program = ShaderProgram{
+            entry->VertexSource.c_str(),
+            entry->FragmentSource.c_str(),
+            entry->GeometrySource.empty() ? nullptr : entry->GeometrySource.c_str()
+        };
+
+        auto& program = entry->Program;
+        bool built = cache ? cache->Build(program, define_block) : program.Build();
+        if (!built) return InvalidMaterial;
+
+        // samplers never change unit, so they are set once instead of per command
+        program.BindUniformBlock("Frame", frame_block_binding);
+        program.Use();
+        program[program.Uniform("tex")] = 0;
+        entry->AlphaCutoff = program.Uniform("alpha_cutoff");
+        entry->BatchOrigin = program.Uniform("batch_origin");
+
+        m_Programs.push_back(std::move(entry));
+        return static_cast<MaterialId>(m_Programs.size() - 1);
+    }
+
+    // unknown materials fall back to the default program
+    constexpr MaterialId Resolve(MaterialId material) const noexcept
+    {
+        return material < m_Programs.size() ? material : DefaultMaterial;
+    }
+
+    void Use(MaterialId material) const noexcept
+    {
+        m_Programs[Resolve(material)]->Program.Use();
+    }
+
+    // expects material to be in use
+    void SetAlphaCutoff(MaterialId material, float cutoff) noexcept
+    {
+        auto& entry = *m_Programs[Resolve(material)];
+        entry.Program[entry.AlphaCutoff] = cutoff;
+    }
+
+    // expects material to be in use
+    void SetBatchOrigin(MaterialId material, math::Vec2<float> origin) noexcept
+    {
+        auto& entry = *m_Programs[Resolve(material)];
+        entry.Program[entry.BatchOrigin] = origin;
+    }
+
+    constexpr const ShaderProgram& Program(MaterialId material) const noexcept
+    {
+        return m_Programs[Resolve(material)]->Program;
+    }
+
+    constexpr size_t Size() const noexcept
+    {
+        return m_Programs.size();
+    }
+
+private:
+    // boxed: the programs keep views of their sources
+    struct Entry {
+        std::string VertexSource;
+        std::string FragmentSource;
+        std::string GeometrySource;
+        ShaderProgram Program;
+        UniformHandle AlphaCutoff{ -1 };
+        UniformHandle BatchOrigin{ -1 };
+    };
+
+    static std::string WithDefines(std::string_view source, std::string_view define_block)
+    {
+        if (define_block.empty()) return std::string{ source };
+
+        auto version_end = source.starts_with("#version") ? source.find('\n') : std::string_view::npos;
+        if (version_end == std::string_view::npos) {
+            return std::string{ define_block } + std::string{ source };
+        }
+
+        std::string result{ source.substr(0, version_end + 1) };
+        result += define_block;
+        result += source.substr(version_end + 1);
+        return result;
+    }
+
+    std::vector<std::unique_ptr<Entry>> m_Programs;
+};
+
+} // gfx
@@ -0,0 +1,274 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+namespace gfx
+{
+
+namespace
+{
+
+// what an incomplete GL texture samples
+const uint32_t MissingTexel = PackTint(math::Color{ 0.0f, 0.0f, 0.0f, 1.0f });
+
+// a * b / 255 rounded, exact for bytes; the SSE2 path computes the same in 16 bit lanes
+constexpr uint32_t Mul(uint32_t a, uint32_t b) noexcept
+{
+    uint32_t t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// src over dst, both terms rounded like the 8 bit blenders (llvmpipe matches it within one unit)
+constexpr uint32_t Blend(uint32_t src, uint32_t dst, uint32_t alpha) noexcept
+{
+    return Mul(src, alpha) + Mul(dst, 255 - alpha);
+}
+
+constexpr int Wrap(int i, int n) noexcept
+{
+    if (static_cast<unsigned>(i) < static_cast<unsigned>(n)) return i;
+    i %= n;
+    return i < 0 ? i + n : i;
+}
+
+// rasterizers snap the vertices to a subpixel grid, 8 bits on the common ones, so ties happen there
+float Snap(float pixels) noexcept
+{
+    return std::round(pixels * 256.0f) / 256.0f;
+}
+
+int Texel(float coordinate, int size) noexcept
+{
+    return Wrap(static_cast<int>(std::floor(coordinate)), size);
+}
+
+#ifdef GFX_VERTEX_WRITER_SSE2
+// on 8 lanes of bytes widened to 16 bits, nothing overflows: 255 * 255 + 128 + 254 < 65536
+__m128i Mul(__m128i a, __m128i b) noexcept
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__m128i Blend(__m128i src, __m128i dst, __m128i alpha) noexcept
+{
+    return _mm_add_epi16(Mul(src, alpha), Mul(dst, _mm_sub_epi16(_mm_set1_epi16(255), alpha)));
+}
+
+// the alpha of each of the 2 pixels in the 4 lanes of the pixel
+__m128i SplatAlpha(__m128i pixels) noexcept
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+#endif
+
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, core::ThreadPool* pool)
+    : m_Width{ width },
+    m_Height{ height },
+    m_TilesX{ (width + TileSize - 1) / TileSize },
+    m_TilesY{ (height + TileSize - 1) / TileSize },
+    m_Pool{ pool },
+    m_Color(static_cast<size_t>(width) * static_cast<size_t>(height) * 4),
+    m_Depth(static_cast<size_t>(width) * static_cast<size_t>(height), -DepthRange),
+    m_Bins(static_cast<size_t>(m_TilesX) * static_cast<size_t>(m_TilesY))
+{
+}
+
+void SoftwareRasterizer::SetTexture(TextureHandle texture, int width, int height, const unsigned char* rgba)
+{
+    auto& copy = m_Textures[texture];
+    copy.Width = width;
+    copy.Height = height;
+    copy.Texels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+    std::memcpy(copy.Texels.data(), rgba, copy.Texels.size() * sizeof(uint32_t));
+}
+
+void SoftwareRasterizer::ReleaseTexture(TextureHandle texture)
+{
+    m_Textures.erase(texture);
+}
+
+void SoftwareRasterizer::Clear(const math::Color& color)
+{
+    const uint32_t packed = PackTint(color);
+    for (size_t i = 0; i < m_Depth.size(); ++i) {
+        std::memcpy(m_Color.data() + 4 * i, &packed, sizeof(packed));
+    }
+    std::fill(m_Depth.begin(), m_Depth.end(), -DepthRange);
+}
+
+void SoftwareRasterizer::AddQuad(const StandardVertex& min, const StandardVertex& max, TextureHandle texture, RenderPass pass, const math::Bbox& view)
+{
+    // GL clips what is outside the depth range
+    if (min.Z < -DepthRange || min.Z > 0.0f) return;
+
+    const float scale_x = static_cast<float>(m_Width) / view.Size.x();
+    const float scale_y = static_cast<float>(m_Height) / view.Size.y();
+    const float left = Snap((min.X - view.Pos.x()) * scale_x);
+    const float right = Snap((max.X - view.Pos.x()) * scale_x);
+    const float top = Snap((min.Y - view.Pos.y()) * scale_y);
+    const float bottom = Snap((max.Y - view.Pos.y()) * scale_y);
+    if (!(right > left) || !(bottom > top)) return;
+
+    // the pixels with their center in [left, right) x (top, bottom]: the left edge and the bottom edge
+    // of the framebuffer, which goes bottom up in GL, own the centers exactly on them
+    Quad quad{};
+    quad.X0 = std::max(0, static_cast<int>(std::ceil(left - 0.5f)));
+    quad.X1 = std::min(m_Width, static_cast<int>(std::ceil(right - 0.5f)));
+    quad.Y0 = std::max(0, static_cast<int>(std::floor(top - 0.5f)) + 1);
+    quad.Y1 = std::min(m_Height, static_cast<int>(std::floor(bottom - 0.5f)) + 1);
+    if (quad.X0 >= quad.X1 || quad.Y0 >= quad.Y1) return;
+
+    auto found = m_Textures.find(texture);
+    quad.Texture = found != m_Textures.end() ? &found->second : nullptr;
+    const float texture_width = quad.Texture ? static_cast<float>(quad.Texture->Width) : 1.0f;
+    const float texture_height = quad.Texture ? static_cast<float>(quad.Texture->Height) : 1.0f;
+    quad.DsDx = (max.U - min.U) * texture_width / (right - left);
+    quad.S0 = min.U * texture_width + (0.5f - left) * quad.DsDx;
+    quad.DtDy = (max.V - min.V) * texture_height / (bottom - top);
+    quad.T0 = min.V * texture_height + (0.5f - top) * quad.DtDy;
+    quad.Depth = min.Z;
+    quad.Tint = min.Tint;
+    // the cutoffs of GpuHandle::ExecuteCommands, 0.5 and 1 / 255, as the smallest alpha byte kept
+    quad.Cutoff = pass == RenderPass::Opaque ? 128 : 1;
+    quad.Blend = pass == RenderPass::Translucent;
+
+    const auto index = static_cast<uint32_t>(m_Quads.size());
+    m_Quads.push_back(quad);
+    for (int tile_y = quad.Y0 / TileSize; tile_y <= (quad.Y1 - 1) / TileSize; ++tile_y) {
+        for (int tile_x = quad.X0 / TileSize; tile_x <= (quad.X1 - 1) / TileSize; ++tile_x) {
+            m_Bins[static_cast<size_t>(tile_y) * m_TilesX + tile_x].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::Rasterize()
+{
+    std::vector<size_t> tiles;
+    for (size_t tile = 0; tile < m_Bins.size(); ++tile) {
+        if (!m_Bins[tile].empty()) tiles.push_back(tile);
+    }
+    m_TilesDrawn = tiles.size();
+
+    // tiles never share a pixel, so they need no ordering between them; interleaved for the balance
+    size_t tasks = m_Pool ? std::min(m_Pool->Size() + 1, tiles.size()) : 1;
+    auto draw_every = [this, &tiles, tasks](size_t first) {
+        for (size_t i = first; i < tiles.size(); i += tasks) {
+            DrawTile(tiles[i]);
+        }
+    };
+    std::vector<std::future<void>> pending;
+    for (size_t task = 1; task < tasks; ++task) {
+        pending.push_back(m_Pool->Submit([&draw_every, task]() { draw_every(task); }));
+    }
+    draw_every(0);
+    for (auto& task : pending) {
+        task.get();
+    }
+
+    for (auto& bin : m_Bins) {
+        bin.clear();
+    }
+}
+
+void SoftwareRasterizer::DrawTile(size_t tile)
+{
+    const int tile_x0 = static_cast<int>(tile % m_TilesX) * TileSize;
+    const int tile_y0 = static_cast<int>(tile / m_TilesX) * TileSize;
+    const int tile_x1 = std::min(tile_x0 + TileSize, m_Width);
+    const int tile_y1 = std::min(tile_y0 + TileSize, m_Height);
+
+    for (auto index : m_Bins[tile]) {
+        const auto& quad = m_Quads[index];
+        const int x0 = std::max(quad.X0, tile_x0);
+        const int x1 = std::min(quad.X1, tile_x1);
+        const int y0 = std::max(quad.Y0, tile_y0);
+        const int y1 = std::min(quad.Y1, tile_y1);
+
+        // the texel columns are the same on every row of the quad
+        int columns[TileSize];
+        if (quad.Texture) {
+            for (int x = x0; x < x1; ++x) {
+                columns[x - x0] = Texel(quad.S0 + static_cast<float>(x) * quad.DsDx, quad.Texture->Width);
+            }
+        }
+        for (int y = y0; y < y1; ++y) {
+            DrawSpan(quad, columns, x0, x1, y);
+        }
+    }
+}
+
+void SoftwareRasterizer::DrawSpan(const Quad& quad, const int* columns, int x0, int x1, int y)
+{
+    // the texels of the span, gathered first: SSE2 has no gather
+    uint32_t texels[TileSize];
+    if (quad.Texture) {
+        const int row = Texel(quad.T0 + static_cast<float>(y) * quad.DtDy, quad.Texture->Height);
+        const uint32_t* source = quad.Texture->Texels.data() + static_cast<size_t>(row) * quad.Texture->Width;
+        for (int i = 0; i < x1 - x0; ++i) {
+            texels[i] = source[columns[i]];
+        }
+    } else {
+        std::fill(texels, texels + (x1 - x0), MissingTexel);
+    }
+
+    const size_t offset = static_cast<size_t>(y) * m_Width;
+    uint8_t* color = m_Color.data() + 4 * offset;
+    float* depth = m_Depth.data() + offset;
+    int x = x0;
+
+#ifdef GFX_VERTEX_WRITER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i tint_lanes = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(quad.Tint)), zero);
+    const __m128i kept_alpha = _mm_set1_epi32(quad.Cutoff - 1);
+    const __m128 z = _mm_set1_ps(quad.Depth);
+    for (; x + 4 <= x1; x += 4) {
+        __m128i texel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + (x - x0)));
+        __m128i src_lo = Mul(_mm_unpacklo_epi8(texel, zero), tint_lanes);
+        __m128i src_hi = Mul(_mm_unpackhi_epi8(texel, zero), tint_lanes);
+        __m128i src = _mm_packus_epi16(src_lo, src_hi);
+
+        __m128 stored = _mm_loadu_ps(depth + x);
+        __m128 nearer = _mm_cmpgt_ps(z, stored);
+        __m128i kept = _mm_and_si128(_mm_cmpgt_epi32(_mm_srli_epi32(src, 24), kept_alpha), _mm_castps_si128(nearer));
+
+        auto* pixels = reinterpret_cast<__m128i*>(color + 4 * x);
+        __m128i dst = _mm_loadu_si128(pixels);
+        if (quad.Blend) {
+            __m128i out_lo = Blend(src_lo, _mm_unpacklo_epi8(dst, zero), SplatAlpha(src_lo));
+            __m128i out_hi = Blend(src_hi, _mm_unpackhi_epi8(dst, zero), SplatAlpha(src_hi));
+            src = _mm_packus_epi16(out_lo, out_hi);
+        } else {
+            __m128 kept_depth = _mm_castsi128_ps(kept);
+            _mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(kept_depth, z), _mm_andnot_ps(kept_depth, stored)));
+        }
+        _mm_storeu_si128(pixels, _mm_or_si128(_mm_and_si128(kept, src), _mm_andnot_si128(kept, dst)));
+    }
+#endif
+
+    uint8_t tint[4];
+    std::memcpy(tint, &quad.Tint, sizeof(tint));
+    for (; x < x1; ++x) {
+        uint8_t texel[4];
+        std::memcpy(texel, texels + (x - x0), sizeof(texel));
+        uint32_t src[4];
+        for (int c = 0; c < 4; ++c) {
+            src[c] = Mul(texel[c], tint[c]);
+        }
+        if (src[3] < quad.Cutoff || !(quad.Depth > depth[x])) continue;
+
+        uint8_t* dst = color + 4 * x;
+        for (int c = 0; c < 4; ++c) {
+            dst[c] = static_cast<uint8_t>(quad.Blend ? Blend(src[c], dst[c], src[3]) : src[c]);
+        }
+        if (!quad.Blend) {
+            depth[x] = quad.Depth;
+        }
+    }
+}
+
+} // gfx
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../core/ThreadPool.h"
+#include "../math/math.h"
+#include "GpuDataConverter.h"
+#include "RenderCommandQueue.h"
+#include "Sprite.h"
+#include "SpriteStorage.h"
+#include "TextureRegistry.h"
+#include "VertexFormat.h"
+#include "VertexWriter.h"
+
+namespace gfx
+{
+
+/* Draws a SpriteStorage on the CPU, into a width x height RGBA8 framebuffer with a float depth buffer:
+ * for tests and golden images without a GPU, and to check the GL path against.
+ * The sprites go through the same GpuDataConverter as Renderer::Flush, and the commands are replayed
+ * with the state GpuHandle sets: opaque pass with depth writes and alpha cutoff 0.5, then translucent
+ * pass blended (src alpha, one minus src alpha) without depth writes, depth test GL_LESS throughout.
+ * The quads are binned in TileSize tiles, in command order, and the tiles are filled in parallel
+ * on the pool, 4 pixels at a time with SSE2. The output does not depend on the pool.
+ * Differences with GL: nearest texel sampling (repeat wrap) instead of bilinear and mipmaps,
+ * every material draws like the default one, and the tint and the blend round
+ * in bytes, so a channel may be one unit off.
+ * Retained layers and debug primitives are GPU only. */
+class SoftwareRasterizer {
+public:
+    constexpr static int TileSize = 64;
+    // same as Renderer::DepthRange: depths go from -DepthRange (far, the clear value) to 0 (near)
+    constexpr static float DepthRange = 65536.0f;
+
+    SoftwareRasterizer(int width, int height, core::ThreadPool* pool = nullptr);
+
+    /* The rasterizer cannot read textures back from the GPU, it samples its own copy of each.
+     * rgba is width x height RGBA8, rows top down like an Image. Sprites of textures it has no copy of
+     * sample opaque black, like an incomplete GL texture. */
+    void SetTexture(TextureHandle texture, int width, int height, const unsigned char* rgba);
+    void ReleaseTexture(TextureHandle texture);
+
+    void Clear(const math::Color& color);
+
+    /* Culls and sorts sprites like Renderer::Flush, then draws them; the caller clears the storage.
+     * view is the area of the world stretched over the framebuffer. */
+    template <size_t BatchSprites>
+    void Draw(SpriteStorage<BatchSprites>& sprites, const math::Bbox& view)
+    {
+        sprites.Cull(view);
+        if (sprites.Size() == 0) return;
+
+        GpuDataConverter<BatchSprites, StandardVertexFormat> converter{ sprites, {}, m_Pool };
+        const auto& queue = converter.DrawingData();
+        m_Quads.clear();
+        for (size_t batch = 0; batch < queue.BatchCount(); ++batch) {
+            auto vertices = converter.VertexData(batch);
+            for (size_t i = queue.BatchBegin(batch); i < queue.BatchEnd(batch); ++i) {
+                auto parameters = queue.Parameters(i);
+                for (GLsizei run = 0; run < parameters.DrawCount; ++run) {
+                    const auto* vertex = vertices.data() + static_cast<size_t>(parameters.First[run]) * StandardVertexFormat::VerticesPerSprite;
+                    for (GLsizei sprite = 0; sprite < parameters.Count[run]; ++sprite, vertex += StandardVertexFormat::VerticesPerSprite) {
+                        // top-left and bottom-right corners, see StandardVertexFormat::WriteRect
+                        AddQuad(vertex[0], vertex[3], queue.Texture(i), queue.Pass(i), view);
+                    }
+                }
+            }
+        }
+        Rasterize();
+    }
+
+    // top down rows of RGBA8, like a FrameCapture frame
+    constexpr const std::vector<uint8_t>& Pixels() const noexcept { return m_Color; }
+    constexpr int Width() const noexcept { return m_Width; }
+    constexpr int Height() const noexcept { return m_Height; }
+    // tiles filled by the last Draw, a tile is filled once whatever the number of quads over it
+    constexpr size_t TilesDrawn() const noexcept { return m_TilesDrawn; }
+
+private:
+    struct CpuTexture {
+        int Width;
+        int Height;
+        std::vector<uint32_t> Texels;
+    };
+
+    /* A sprite in pixels: the covered pixels [X0, X1) x [Y0, Y1), texel coordinates as S0 + x * DsDx
+     * at the center of pixel x (T the same along y), and the state of its command. */
+    struct Quad {
+        int X0, Y0, X1, Y1;
+        float S0, DsDx;
+        float T0, DtDy;
+        float Depth;
+        uint32_t Tint;
+        const CpuTexture* Texture;
+        uint8_t Cutoff; // alpha below it is discarded
+        bool Blend; // translucent pass: blended, no depth write
+    };
+
+    void AddQuad(const StandardVertex& min, const StandardVertex& max, TextureHandle texture, RenderPass pass, const math::Bbox& view);
+    void Rasterize();
+    void DrawTile(size_t tile);
+    // columns are the texel columns of [x0, x1)
+    void DrawSpan(const Quad& quad, const int* columns, int x0, int x1, int y);
+
+    int m_Width;
+    int m_Height;
+    int m_TilesX;
+    int m_TilesY;
+    core::ThreadPool* m_Pool;
+    std::vector<uint8_t> m_Color;
+    std::vector<float> m_Depth;
+    std::vector<Quad> m_Quads;
+    std::vector<std::vector<uint32_t>> m_Bins; // quad indices per tile, in draw order
+    size_t m_TilesDrawn{ 0 };
+    std::unordered_map<TextureHandle, CpuTexture> m_Textures;
+};
+
+} // gfx
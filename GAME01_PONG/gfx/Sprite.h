@@ -5,6 +5,8 @@
 
 #include "../math/math.h"
 #include "Texture.h"
+#include "ShaderRegistry.h"
+#include "TextureRegistry.h"
 
 namespace gfx
 {
@@ -13,17 +15,76 @@ enum class SpriteType : uint8_t {
     TexturedRect,
 };
 
+/* Opaque and cutout sprites are drawn first, without blending and front to back so that
+ * the depth test rejects the hidden fragments early. Translucent ones follow, back to front. */
+enum class RenderPass : uint8_t {
+    Opaque,
+    Translucent,
+};
+
+constexpr RenderPass PassOf(AlphaClass alpha) noexcept
+{
+    return alpha == AlphaClass::Translucent ? RenderPass::Translucent : RenderPass::Opaque;
+}
+
+/* What orders the sprites of a frame, everything in it is an integer but the depth.
+ * The pass is looked up once when the sprite is submitted. */
+struct DrawKey {
+    RenderPass Pass;
+    MaterialId Material;
+    TextureHandle Texture;
+    float Depth;
+
+    // sprites with the same material and texture go in the same bucket
+    constexpr bool SameState(const DrawKey& other) const noexcept
+    {
+        return Material == other.Material && Texture == other.Texture;
+    }
+};
+
+/* Draw order of a frame: by pass, then opaque sprites by material and texture (to batch them,
+ * a program switch costs more than a texture switch) and front to back,
+ * translucent sprites back to front, then by material and texture.
+ * Greater depths are nearer to the camera. */
+constexpr bool DrawsBefore(const DrawKey& a, const DrawKey& b) noexcept
+{
+    if (a.Pass != b.Pass) {
+        return a.Pass < b.Pass;
+    }
+
+    if (a.Pass == RenderPass::Opaque) {
+        if (a.Material != b.Material) return a.Material < b.Material;
+        if (a.Texture != b.Texture) return a.Texture < b.Texture;
+        return a.Depth > b.Depth;
+    }
+
+    if (a.Depth != b.Depth) return a.Depth < b.Depth;
+    if (a.Material != b.Material) return a.Material < b.Material;
+    return a.Texture < b.Texture;
+}
+
 struct Sprite {
     Sprite() {}
-    Sprite(math::Bbox bbox, const Texture& tex)
+    Sprite(math::Bbox bbox, TextureHandle tex)
         : Bbox{ bbox }, Texture{ tex }
     {
     }
 
+    Sprite(math::Bbox bbox, TextureHandle tex, math::Bbox uv)
+        : Bbox{ bbox }, Texture{ tex }, Uv{ uv }
+    {
+    }
+
+    // the whole texture by default, a frame of a sprite sheet otherwise
+    constexpr static math::Bbox FullUv{ 0.0f, 0.0f, 1.0f, 1.0f };
+
     math::Bbox Bbox;
     float Depth{ std::numeric_limits<float>::quiet_NaN() }; // initialize to NaN
-    gfx::Texture Texture;
+    TextureHandle Texture{ InvalidTexture }; // borrowed, a SpriteLayer takes its own reference
     SpriteType Type{ SpriteType::TexturedRect };
+    math::Bbox Uv{ FullUv };
+    math::Color Tint{ 0xffffffffu }; // multiplies the texture color
+    MaterialId Material{ DefaultMaterial }; // the program drawing it, see Renderer::CreateMaterial
 };
 
 }
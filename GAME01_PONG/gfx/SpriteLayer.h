@@ -0,0 +1,330 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../core/multivector.h"
+#include "../math/math.h"
+#include "GpuBuffer.h"
+#include "GpuDataConverter.h"
+#include "GpuHandle.h"
+#include "QuadIndexBuffer.h"
+#include "RenderCommandQueue.h"
+#include "Sprite.h"
+#include "SpriteStorage.h"
+#include "TextureRegistry.h"
+#include "UniformGrid.h"
+#include "VertexArray.h"
+#include "VertexFormat.h"
+
+namespace gfx
+{
+
+using SpriteHandle = uint32_t;
+
+/* Retained sprites: they are registered once and live in a GPU buffer owned by the layer.
+ * Every sprite keeps its slot (the handle) until it is removed, so a frame only uploads
+ * the slots that changed, merged in contiguous ranges, and the draw commands are rebuilt
+ * only when a sprite is added, removed or changed, or when the view moves.
+ * Slots are not contiguous per material and texture, every command is a glMultiDrawElementsBaseVertex
+ * over its runs of consecutive slots, with the quad indices shared by the renderer.
+ * The slots are indexed by a uniform grid: only the ones around the view get a command,
+ * so a scrolling level costs O(visible) and not O(sprites in the layer).
+ * Vertices are written relative to the world origin, with the compact format the layer spans +-32767 pixels.
+ * The layer holds a reference on the texture of every live sprite, released when the sprite is removed or changes texture. */
+template <typename VertexFormat = StandardVertexFormat>
+class SpriteLayer {
+public:
+    // dirty slots closer than this are uploaded with a single glBufferSubData
+    constexpr static size_t CoalesceGap = 4;
+
+    SpriteLayer(TextureRegistry& textures, float default_depth, size_t capacity = 64, float cell_size = 256.0f)
+        : m_Textures{ textures },
+        m_VertexBuffer{ GpuBuffer::Target::ArrayBuffer },
+        m_Grid{ cell_size },
+        m_DefaultDepth{ default_depth }
+    {
+        Reserve(std::max<size_t>(capacity, 1));
+    }
+
+    SpriteLayer(const SpriteLayer&) = delete;
+    SpriteLayer& operator=(const SpriteLayer&) = delete;
+
+    ~SpriteLayer()
+    {
+        for (SpriteHandle handle = 0; handle < m_Slots.size(); ++handle) {
+            if (m_Slots.get<4>()[handle]) m_Textures.Release(m_Slots.get<1>()[handle]);
+        }
+    }
+
+    SpriteHandle Add(const Sprite& sprite)
+    {
+        SpriteHandle handle;
+        if (!m_FreeSlots.empty()) {
+            handle = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        } else {
+            handle = static_cast<SpriteHandle>(m_Slots.size());
+            m_Slots.push_back(m_DefaultDepth, sprite.Texture, math::Vec2<float>{}, math::Vec2<float>{}, uint8_t{ 0 }, sprite.Uv, WhiteTint, RenderPass::Opaque, sprite.Material);
+            m_Vertices.resize(m_Slots.size() * VerticesPerSprite);
+        }
+
+        m_Slots.get<4>()[handle] = 1;
+        m_Textures.Acquire(sprite.Texture);
+        m_LiveCount++;
+        m_CommandsDirty = true;
+        Write(handle, sprite);
+        return handle;
+    }
+
+    // Update and SetPosition of a removed handle do nothing, the slot stays free
+    void Update(SpriteHandle handle, const Sprite& sprite)
+    {
+        auto [depth, texture, position, size, alive, uv, tint, pass, material] = m_Slots[handle];
+        if (!alive) return;
+        float new_depth = std::isnan(sprite.Depth) ? m_DefaultDepth : sprite.Depth;
+        if (depth == new_depth && texture == sprite.Texture && material == sprite.Material
+            && position == sprite.Bbox.Pos && size == sprite.Bbox.Size && uv == sprite.Uv && tint == PackTint(sprite.Tint)) {
+            return;
+        }
+
+        if (texture != sprite.Texture) {
+            m_Textures.Acquire(sprite.Texture);
+            m_Textures.Release(texture);
+        }
+        Write(handle, sprite);
+    }
+
+    void SetPosition(SpriteHandle handle, math::Vec2<float> position)
+    {
+        if (!m_Slots.get<4>()[handle] || m_Slots.get<2>()[handle] == position) return;
+
+        m_Slots.get<2>()[handle] = position;
+        m_Grid.Update(handle, math::Bbox{ position, m_Slots.get<3>()[handle] });
+        m_CommandsDirty = true;
+        MarkDirty(handle);
+    }
+
+    void Remove(SpriteHandle handle)
+    {
+        auto& alive = m_Slots.get<4>()[handle];
+        if (!alive) return;
+
+        alive = 0;
+        m_Textures.Release(std::exchange(m_Slots.get<1>()[handle], InvalidTexture));
+        m_Grid.Remove(handle);
+        m_LiveCount--;
+        m_FreeSlots.push_back(handle);
+        m_CommandsDirty = true;
+    }
+
+    constexpr void SetVisible(bool visible) noexcept
+    {
+        m_Visible = visible;
+    }
+
+    constexpr bool Visible() const noexcept
+    {
+        return m_Visible;
+    }
+
+    constexpr size_t Size() const noexcept
+    {
+        return m_LiveCount;
+    }
+
+    constexpr size_t VisibleCount() const noexcept
+    {
+        return m_VisibleCount;
+    }
+
+    /* Brings the GPU copy up to date and selects the sprites overlapping view.
+     * Returns the number of glBufferSubData issued. */
+    size_t Sync(const math::Bbox& view)
+    {
+        if (!(view == m_View)) {
+            m_View = view;
+            m_CommandsDirty = true;
+        }
+
+        if (m_Slots.size() > m_Capacity) {
+            Reserve(std::max(m_Slots.size(), m_Capacity * 2));
+        }
+
+        size_t uploads = UploadDirtyRanges();
+        if (m_CommandsDirty) {
+            BuildCommands();
+            m_CommandsDirty = false;
+        }
+        return uploads;
+    }
+
+    // bytes given to glBufferSubData since the last call
+    constexpr size_t TakeUploadedBytes() noexcept
+    {
+        return std::exchange(m_UploadedBytes, 0);
+    }
+
+    constexpr const gfx::VertexArray& VertexArray() const noexcept
+    {
+        return m_VertexArray;
+    }
+
+    constexpr const RenderCommandQueue& Commands() const noexcept
+    {
+        return m_Commands;
+    }
+
+private:
+    using Vertex = typename VertexFormat::Vertex;
+    constexpr static size_t VerticesPerSprite = VertexFormat::VerticesPerSprite;
+
+    void Write(SpriteHandle handle, const Sprite& sprite)
+    {
+        m_Slots.get<0>()[handle] = std::isnan(sprite.Depth) ? m_DefaultDepth : sprite.Depth;
+        m_Slots.get<1>()[handle] = sprite.Texture;
+        m_Slots.get<2>()[handle] = sprite.Bbox.Pos;
+        m_Slots.get<3>()[handle] = sprite.Bbox.Size;
+        m_Slots.get<5>()[handle] = sprite.Uv;
+        m_Slots.get<6>()[handle] = PackTint(sprite.Tint);
+        m_Slots.get<7>()[handle] = PassOf(m_Textures.Alpha(sprite.Texture));
+        m_Slots.get<8>()[handle] = sprite.Material;
+        m_Grid.Update(handle, sprite.Bbox);
+        m_CommandsDirty = true;
+        MarkDirty(handle);
+    }
+
+    void MarkDirty(SpriteHandle handle)
+    {
+        if (m_Dirty.size() < m_Slots.size()) {
+            m_Dirty.resize(m_Slots.size(), false);
+        }
+        if (!m_Dirty[handle]) {
+            m_Dirty[handle] = true;
+            m_DirtySlots.push_back(handle);
+        }
+    }
+
+    // a growth reallocates the GPU buffer, so every slot gets uploaded again
+    void Reserve(size_t capacity)
+    {
+        m_Capacity = capacity;
+        m_VertexBuffer.Bind();
+        m_VertexBuffer.Allocate(m_Capacity * VerticesPerSprite * sizeof(Vertex), GpuBuffer::Usage::StaticDraw);
+        VertexFormat::SetLayout(m_VertexArray);
+        m_VertexBuffer.Unbind();
+
+        for (SpriteHandle handle = 0; handle < m_Slots.size(); ++handle) {
+            MarkDirty(handle);
+        }
+    }
+
+    size_t UploadDirtyRanges()
+    {
+        if (m_DirtySlots.empty()) return 0;
+
+        std::sort(m_DirtySlots.begin(), m_DirtySlots.end());
+        for (auto handle : m_DirtySlots) {
+            VertexFormat::WriteRect(
+                m_Vertices.data() + handle * VerticesPerSprite,
+                math::Bbox{ m_Slots.get<2>()[handle], m_Slots.get<3>()[handle] },
+                m_Slots.get<0>()[handle],
+                m_Slots.get<5>()[handle],
+                m_Slots.get<6>()[handle],
+                math::Vec2<float>{}
+            );
+            m_Dirty[handle] = false;
+        }
+
+        size_t uploads = 0;
+        m_VertexBuffer.Bind();
+        for (size_t i = 0; i < m_DirtySlots.size();) {
+            size_t first = m_DirtySlots[i];
+            size_t last = first;
+            while (++i < m_DirtySlots.size() && m_DirtySlots[i] - last <= CoalesceGap) {
+                last = m_DirtySlots[i];
+            }
+
+            size_t offset = first * VerticesPerSprite;
+            m_VertexBuffer.SetData(m_Vertices.data() + offset, (last - first + 1) * VerticesPerSprite, offset * sizeof(Vertex));
+            m_UploadedBytes += (last - first + 1) * VerticesPerSprite * sizeof(Vertex);
+            uploads++;
+        }
+        m_VertexBuffer.Unbind();
+
+        m_DirtySlots.clear();
+        return uploads;
+    }
+
+    void BuildCommands()
+    {
+        m_Commands.Clear();
+
+        std::vector<SpriteHandle> order;
+        m_Grid.Query(m_View, order);
+        std::erase_if(order, [this](SpriteHandle handle) {
+            return !m_View.Intersects(math::Bbox{ m_Slots.get<2>()[handle], m_Slots.get<3>()[handle] });
+        });
+        m_VisibleCount = order.size();
+
+        auto key = [this](SpriteHandle handle) {
+            return DrawKey{ m_Slots.get<7>()[handle], m_Slots.get<8>()[handle], m_Slots.get<1>()[handle], m_Slots.get<0>()[handle] };
+        };
+        std::sort(order.begin(), order.end(), [&key](SpriteHandle a, SpriteHandle b) {
+            auto a_key = key(a);
+            auto b_key = key(b);
+            if (!a_key.SameState(b_key) || a_key.Depth != b_key.Depth) {
+                return DrawsBefore(a_key, b_key);
+            }
+            return a < b;
+        });
+
+        // consecutive slots drawn one after the other merge in a run, one indexed draw
+        for (size_t i = 0; i < order.size();) {
+            auto bucket = key(order[i]);
+            std::vector<int> firsts;
+            std::vector<GLsizei> counts;
+            for (; i < order.size() && key(order[i]).SameState(bucket); ++i) {
+                auto slot = static_cast<int>(order[i]);
+                if (!firsts.empty() && firsts.back() + counts.back() == slot && static_cast<size_t>(counts.back()) < QuadIndexBuffer::MinCapacity) {
+                    counts.back()++;
+                    continue;
+                }
+                firsts.push_back(slot);
+                counts.push_back(1);
+            }
+
+            auto draw_count = static_cast<GLsizei>(firsts.size());
+            m_Commands.Push(RenderCommand{ bucket.Texture, VertexFormat::Mode, std::move(firsts), std::move(counts), draw_count, 0, bucket.Pass, bucket.Material });
+        }
+    }
+
+    TextureRegistry& m_Textures;
+    gfx::VertexArray m_VertexArray;
+    GpuBuffer m_VertexBuffer;
+    size_t m_Capacity{ 0 };
+
+    // depth, texture, position, size, alive, uv, tint, pass, material
+    core::multivector<float, TextureHandle, math::Vec2<float>, math::Vec2<float>, uint8_t, math::Bbox, uint32_t, RenderPass, MaterialId> m_Slots;
+    std::vector<Vertex> m_Vertices;
+    std::vector<SpriteHandle> m_FreeSlots;
+    std::vector<SpriteHandle> m_DirtySlots;
+    std::vector<bool> m_Dirty;
+    RenderCommandQueue m_Commands;
+    UniformGrid m_Grid;
+    math::Bbox m_View;
+
+    float m_DefaultDepth;
+    size_t m_LiveCount{ 0 };
+    size_t m_VisibleCount{ 0 };
+    size_t m_UploadedBytes{ 0 };
+    bool m_CommandsDirty{ false };
+    bool m_Visible{ true };
+};
+
+} // gfx
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "../math/math.h"
+#include "Sprite.h"
+#include "TextureRegistry.h"
+
+namespace gfx
+{
+
+/* One texture holding many frames: every frame is a uv rect of the texture,
+ * so all the sprites drawn from a sheet fall in the same draw bucket. */
+struct SpriteSheet {
+    SpriteSheet() = default;
+
+    // without frames, they are added with AddFrame or SliceGrid
+    SpriteSheet(TextureHandle texture, math::Vec2<float> texture_size)
+        : Texture{ texture },
+        TextureSize{ texture_size }
+    {
+    }
+
+    TextureHandle Texture{ InvalidTexture };
+    math::Vec2<float> TextureSize;
+    std::vector<math::Bbox> Frames; // uv rects
+    std::vector<math::Vec2<float>> FrameSizes; // in pixels
+
+    constexpr size_t FrameCount() const noexcept
+    {
+        return Frames.size();
+    }
+
+    // a sprite showing frame at its size in pixels
+    Sprite FrameSprite(size_t frame, math::Vec2<float> position) const
+    {
+        return Sprite{ math::Bbox{ position, FrameSizes[frame] }, Texture, Frames[frame] };
+    }
+
+    // frames given as pixel rects of the texture, like the ones of an atlas description
+    void AddFrame(const math::Bbox& pixels)
+    {
+        Frames.push_back(math::Bbox{
+            pixels.Pos.x() / TextureSize.x(), pixels.Pos.y() / TextureSize.y(),
+            pixels.Size.x() / TextureSize.x(), pixels.Size.y() / TextureSize.y()
+        });
+        FrameSizes.push_back(pixels.Size);
+    }
+
+    // frames of a regular grid, row by row from the top-left corner;
+    // false and no frames when the texture does not hold a whole frame of that size
+    bool SliceGrid(int frame_width, int frame_height)
+    {
+        if (frame_width <= 0 || frame_height <= 0) return false;
+        int columns = static_cast<int>(TextureSize.x()) / frame_width;
+        int rows = static_cast<int>(TextureSize.y()) / frame_height;
+        if (columns == 0 || rows == 0) return false;
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                AddFrame(math::Bbox{
+                    static_cast<float>(column * frame_width), static_cast<float>(row * frame_height),
+                    static_cast<float>(frame_width), static_cast<float>(frame_height)
+                });
+            }
+        }
+        return true;
+    }
+};
+
+}
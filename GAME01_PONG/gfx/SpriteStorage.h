@@ -1,11 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
+#include <span>
 #include <vector>
 #include <glad/glad.h>
 
 #include "../core/multivector.h"
 #include "../math/math.h"
 #include "Sprite.h"
+#include "VertexFormat.h"
+#include "VertexWriter.h"
 
 namespace gfx
 {
@@ -16,11 +21,6 @@ class SpriteStorage {
 public:
     SpriteStorage() : m_Storage{ MaxSprites } {}
 
-    constexpr static size_t FloatsPerSprite()
-    {
-        return VerticesPerSprite() * 5ull;
-    }
-
     constexpr static size_t VerticesPerSprite()
     {
         return 4ull;
@@ -29,36 +29,90 @@ public:
     constexpr bool InSameBucket(size_t i, size_t j) const noexcept
     {
         const auto& a_type = m_Storage.get<2>()[i];
-        const auto& a_texture = m_Storage.get<1>()[i].GetId();
+        const auto& a_texture = m_Storage.get<1>()[i];
+        const auto& a_material = m_Storage.get<8>()[i];
         const auto& b_type = m_Storage.get<2>()[j];
-        const auto& b_texture = m_Storage.get<1>()[j].GetId();
+        const auto& b_texture = m_Storage.get<1>()[j];
+        const auto& b_material = m_Storage.get<8>()[j];
 
-        return a_type == b_type && a_texture == b_texture;
+        return a_type == b_type && a_material == b_material && a_texture == b_texture;
     }
 
     void Sort()
     {
         m_Storage.sort([](const auto& a, const auto& b) {
-            unsigned int a_texture = std::get<1>(a).GetId();
-            unsigned int b_texture = std::get<1>(b).GetId();
-
-            if (a_texture != b_texture) {
-                return a_texture < b_texture;
+            DrawKey a_key{ std::get<7>(a), std::get<8>(a), std::get<1>(a), std::get<0>(a) };
+            DrawKey b_key{ std::get<7>(b), std::get<8>(b), std::get<1>(b), std::get<0>(b) };
+            if (!a_key.SameState(b_key) || a_key.Depth != b_key.Depth) {
+                return DrawsBefore(a_key, b_key);
             }
 
-            SpriteType a_type = std::get<2>(a);
-            SpriteType b_type = std::get<2>(b);
-            if (a_type != b_type) {
-                return a_type < b_type;
-            }
-
-            return &a < &b;
+            return std::get<2>(a) < std::get<2>(b);
         });
     }
 
-    constexpr void AddSprite(const Sprite& sprite)
+    // pass is the one of the texture of the sprite
+    constexpr void AddSprite(const Sprite& sprite, RenderPass pass)
+    {
+        m_Storage.push_back(sprite.Depth, sprite.Texture, sprite.Type, sprite.Bbox.Pos, sprite.Bbox.Size, sprite.Uv, PackTint(sprite.Tint), pass, sprite.Material);
+    }
+
+    /* Appends whole columns at once, positions and sizes must have the same length.
+     * Sprites take the matching element of depths, or depth when depths is empty,
+     * the matching element of uvs, or the whole texture when uvs is empty,
+     * and the matching element of tints, or white when tints is empty. */
+    void AddSprites(
+        std::span<const math::Vec2<float>> positions,
+        std::span<const math::Vec2<float>> sizes,
+        TextureHandle texture,
+        RenderPass pass,
+        MaterialId material,
+        std::span<const float> depths,
+        float depth,
+        std::span<const math::Bbox> uvs = {},
+        std::span<const math::Color> tints = {})
+    {
+        const auto count = std::min(positions.size(), sizes.size());
+        auto& depth_column = m_Storage.get<0>();
+        if (depths.size() >= count) {
+            depth_column.insert(depth_column.end(), depths.begin(), depths.begin() + count);
+        } else {
+            depth_column.insert(depth_column.end(), count, depth);
+        }
+        m_Storage.get<1>().insert(m_Storage.get<1>().end(), count, texture);
+        m_Storage.get<2>().insert(m_Storage.get<2>().end(), count, SpriteType::TexturedRect);
+        m_Storage.get<3>().insert(m_Storage.get<3>().end(), positions.begin(), positions.begin() + count);
+        m_Storage.get<4>().insert(m_Storage.get<4>().end(), sizes.begin(), sizes.begin() + count);
+
+        auto& uv_column = m_Storage.get<5>();
+        if (uvs.size() >= count) {
+            uv_column.insert(uv_column.end(), uvs.begin(), uvs.begin() + count);
+        } else {
+            uv_column.insert(uv_column.end(), count, Sprite::FullUv);
+        }
+
+        auto& tint_column = m_Storage.get<6>();
+        if (tints.size() >= count) {
+            std::transform(tints.begin(), tints.begin() + count, std::back_inserter(tint_column), PackTint);
+        } else {
+            tint_column.insert(tint_column.end(), count, WhiteTint);
+        }
+        m_Storage.get<7>().insert(m_Storage.get<7>().end(), count, pass);
+        m_Storage.get<8>().insert(m_Storage.get<8>().end(), count, material);
+    }
+
+    // sprites [first, last) in submission order, before the sort
+    constexpr void SetDepth(size_t first, size_t last, float depth)
     {
-        m_Storage.push_back(sprite.Depth, sprite.Texture, sprite.Type, sprite.Bbox);
+        std::fill(m_Storage.get<0>().begin() + first, m_Storage.get<0>().begin() + last, depth);
+    }
+
+    /* Drops the sprites that do not intersect view, returns how many were dropped. */
+    size_t Cull(const math::Bbox& view)
+    {
+        return m_Storage.erase_if([&view](const auto& sprite) {
+            return !view.Intersects(math::Bbox{ std::get<3>(sprite), std::get<4>(sprite) });
+        });
     }
 
     constexpr size_t Size() const noexcept
@@ -71,7 +125,7 @@ public:
         return m_Storage.get<0>()[i];
     }
 
-    constexpr gfx::Texture Texture(size_t i) const
+    constexpr TextureHandle Texture(size_t i) const
     {
         return m_Storage.get<1>()[i];
     }
@@ -83,7 +137,40 @@ public:
 
     constexpr math::Bbox Bbox(size_t i) const
     {
-        return m_Storage.get<3>()[i];
+        return math::Bbox{ m_Storage.get<3>()[i], m_Storage.get<4>()[i] };
+    }
+
+    constexpr math::Bbox Uv(size_t i) const
+    {
+        return m_Storage.get<5>()[i];
+    }
+
+    // packed RGBA8, see PackTint
+    constexpr uint32_t Tint(size_t i) const
+    {
+        return m_Storage.get<6>()[i];
+    }
+
+    constexpr RenderPass Pass(size_t i) const
+    {
+        return m_Storage.get<7>()[i];
+    }
+
+    constexpr MaterialId Material(size_t i) const
+    {
+        return m_Storage.get<8>()[i];
+    }
+
+    // the columns read by the vertex writers, valid until the storage changes
+    RectColumns Columns() const noexcept
+    {
+        return RectColumns{
+            .Positions = m_Storage.get<3>().data(),
+            .Sizes = m_Storage.get<4>().data(),
+            .Depths = m_Storage.get<0>().data(),
+            .Uvs = m_Storage.get<5>().data(),
+            .Tints = m_Storage.get<6>().data()
+        };
     }
 
     constexpr void Clear() noexcept
@@ -92,8 +179,8 @@ public:
     }
 
 private:
-    // depth, texture, type, bbox
-    core::multivector<float, gfx::Texture, SpriteType, math::Bbox> m_Storage;
+    // depth, texture, type, position, size, uv, tint, pass, material
+    core::multivector<float, TextureHandle, SpriteType, math::Vec2<float>, math::Vec2<float>, math::Bbox, uint32_t, RenderPass, MaterialId> m_Storage;
 };
 
 }
@@ -1,8 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <span>
 #include <glad/glad.h>
 
+// EXT_texture_compression_s3tc, present on every desktop driver but not in core profile headers
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 namespace gfx
 {
 
@@ -14,11 +25,55 @@ struct Image {
     unsigned char* Data;
 };
 
+/* How a texture uses its alpha channel, decided once at load time:
+ * Opaque textures need no blending, Cutout ones only have fully transparent or fully opaque
+ * texels and can be drawn without blending by discarding, Translucent ones need blending. */
+enum class AlphaClass : uint8_t {
+    Opaque,
+    Cutout,
+    Translucent,
+};
+
+constexpr AlphaClass ClassifyAlpha(const unsigned char* rgba, size_t pixel_count) noexcept
+{
+    auto alpha_class = AlphaClass::Opaque;
+    for (size_t i = 0; i < pixel_count; ++i) {
+        unsigned char alpha = rgba[i * 4 + 3];
+        if (alpha == 255) continue;
+        if (alpha != 0) return AlphaClass::Translucent;
+        alpha_class = AlphaClass::Cutout;
+    }
+    return alpha_class;
+}
+
+// one level of a prebuilt mip chain, RGBA8 pixels or compressed blocks
+struct TextureLevel {
+    const void* Data;
+    size_t Size;
+};
+
+/* A view of a GL texture name, copying it does not copy the texture.
+ * The names are owned by the TextureRegistry, or by a RenderTarget for its attachments. */
 class Texture {
 public:
-    Texture() noexcept
+    Texture() noexcept = default;
+
+    explicit constexpr Texture(unsigned int id) noexcept
+        : m_Id{ id }
     {
-        glGenTextures(1, &m_Id);
+    }
+
+    static Texture Generate() noexcept
+    {
+        unsigned int id;
+        glGenTextures(1, &id);
+        return Texture{ id };
+    }
+
+    void Delete() noexcept
+    {
+        glDeleteTextures(1, &m_Id);
+        m_Id = 0;
     }
 
     constexpr unsigned int GetId() const noexcept
@@ -38,11 +93,69 @@ public:
         Unbind();
     }
 
-    constexpr void Allocate(const Image& img) const noexcept
+    /* Storage without data, filled later with glTexSubImage2D (see TextureStreamer).
+     * The mipmaps are generated once the last rows are in. */
+    constexpr void AllocateStorage(int width, int height, AlphaClass alpha) noexcept
     {
+        Bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        Unbind();
+        m_Alpha = alpha;
+    }
+
+    /* Uploads a mip chain built offline, level 0 first, instead of generating it.
+     * compressed_format is 0 for RGBA8 pixels or the GL format of the compressed blocks. */
+    constexpr void AllocateLevels(int width, int height, GLenum compressed_format, std::span<const TextureLevel> levels, AlphaClass alpha) noexcept
+    {
+        Bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size()) - 1);
+        for (GLint level = 0; level < static_cast<GLint>(levels.size()); ++level) {
+            const auto& data = levels[level];
+            if (compressed_format) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, compressed_format, width, height, 0, static_cast<GLsizei>(data.Size), data.Data);
+            } else {
+                glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.Data);
+            }
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        Unbind();
+        m_Alpha = alpha;
+    }
+
+    /* Storage for a render target attachment: no data, no mipmaps, nearest filtering.
+     * Called again with another size it reallocates the same texture. */
+    constexpr void AllocateAttachment(int width, int height, GLint internal_format, GLenum format, GLenum type) noexcept
+    {
+        Bind();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, nullptr);
+        Unbind();
+        m_Alpha = AlphaClass::Opaque;
+    }
+
+    constexpr void Allocate(const Image& img) noexcept
+    {
+        m_Alpha = ClassifyAlpha(img.Data, static_cast<size_t>(img.Width) * static_cast<size_t>(img.Height));
         Allocate(img.Width, img.Height, img.Data);
     }
 
+    constexpr AlphaClass Alpha() const noexcept
+    {
+        return m_Alpha;
+    }
+
     constexpr void Bind() const noexcept
     {
         glBindTexture(GL_TEXTURE_2D, m_Id);
@@ -53,7 +166,8 @@ public:
         glBindTexture(GL_TEXTURE_2D, 0);
     }
 private:
-    unsigned int m_Id;
+    unsigned int m_Id{ 0 };
+    AlphaClass m_Alpha{ AlphaClass::Translucent };
 };
 
 }
\ No newline at end of file
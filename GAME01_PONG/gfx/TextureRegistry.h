@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "../core/multivector.h"
+#include "Texture.h"
+
+namespace gfx
+{
+
+/* 20 bits of slot index and 12 bits of generation. A slot gets a new generation every time it
+ * is reused, so a handle to a destroyed texture is detected instead of naming another one.
+ * Generation 0 is never issued: the zero handle is never valid. */
+using TextureHandle = uint32_t;
+
+constexpr TextureHandle InvalidTexture = 0;
+
+/* Owns every sprite texture. Sprites, storages and command queues only carry handles,
+ * plain integers, and the metadata (size, format, alpha class, memory) lives here in columns.
+ * Textures are reference counted: Create returns a handle with one reference,
+ * the last Release destroys the texture once the GPU is done with the commands submitted so far. */
+class TextureRegistry {
+public:
+    constexpr static uint32_t IndexBits = 20;
+    constexpr static uint32_t IndexMask = (1u << IndexBits) - 1;
+    constexpr static uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+    TextureRegistry() = default;
+    TextureRegistry(const TextureRegistry&) = delete;
+    TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+    ~TextureRegistry()
+    {
+        for (size_t slot = 0; slot < m_Slots.size(); ++slot) {
+            auto& name = m_Slots.get<0>()[slot];
+            if (name) glDeleteTextures(1, &name);
+        }
+        for (auto& grave : m_Graveyard) {
+            glDeleteSync(grave.Fence);
+            glDeleteTextures(1, &grave.Name);
+        }
+    }
+
+    /* A GL name without storage yet, see the Allocate functions.
+     * Throws std::length_error past 2^20 live textures: the index would not fit the handle. */
+    TextureHandle Create()
+    {
+        uint32_t slot;
+        if (!m_FreeSlots.empty()) {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        } else {
+            if (m_Slots.size() > IndexMask) {
+                throw std::length_error("TextureRegistry::Create");
+            }
+            slot = static_cast<uint32_t>(m_Slots.size());
+            m_Slots.push_back(0u, 0u, 0, 0, GLenum{ 0 }, AlphaClass::Translucent, 0u, size_t{ 0 });
+        }
+
+        auto& generation = m_Slots.get<1>()[slot];
+        generation = (generation + 1) & GenerationMask;
+        if (generation == 0) generation = 1;
+
+        m_Slots.get<0>()[slot] = Texture::Generate().GetId();
+        m_Slots.get<6>()[slot] = 1;
+        m_Live++;
+        return (generation << IndexBits) | slot;
+    }
+
+    void Acquire(TextureHandle handle) noexcept
+    {
+        if (Valid(handle)) m_Slots.get<6>()[Slot(handle)]++;
+    }
+
+    void Release(TextureHandle handle)
+    {
+        if (!Valid(handle)) return;
+
+        auto slot = Slot(handle);
+        if (--m_Slots.get<6>()[slot] > 0) return;
+
+        // the handle dies now, the name once the GPU has run what was already submitted
+        m_Graveyard.push_back(Grave{ m_Slots.get<0>()[slot], glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_Slots.get<7>()[slot] });
+        m_Slots.get<0>()[slot] = 0;
+        m_Slots.get<7>()[slot] = 0;
+        m_Slots.get<1>()[slot] = (m_Slots.get<1>()[slot] + 1) & GenerationMask;
+        m_FreeSlots.push_back(slot);
+        m_Live--;
+    }
+
+    // deletes the released textures the GPU is done with, once per frame
+    void CollectGarbage()
+    {
+        std::erase_if(m_Graveyard, [](Grave& grave) {
+            if (glClientWaitSync(grave.Fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+            glDeleteSync(grave.Fence);
+            glDeleteTextures(1, &grave.Name);
+            return true;
+        });
+    }
+
+    constexpr bool Valid(TextureHandle handle) const noexcept
+    {
+        auto slot = Slot(handle);
+        return handle != InvalidTexture && slot < m_Slots.size()
+            && m_Slots.get<1>()[slot] == (handle >> IndexBits) && m_Slots.get<0>()[slot] != 0;
+    }
+
+    void Allocate(TextureHandle handle, const Image& image) noexcept
+    {
+        if (!Valid(handle)) return;
+
+        auto texture = View(handle);
+        texture.Allocate(image);
+        // the mip chain adds a third
+        Record(handle, image.Width, image.Height, GL_RGBA8, texture.Alpha(), static_cast<size_t>(image.Width) * image.Height * 4 * 4 / 3);
+    }
+
+    void AllocateLevels(TextureHandle handle, int width, int height, GLenum compressed_format, std::span<const TextureLevel> levels, AlphaClass alpha) noexcept
+    {
+        if (!Valid(handle)) return;
+
+        View(handle).AllocateLevels(width, height, compressed_format, levels, alpha);
+        size_t bytes = 0;
+        for (const auto& level : levels) bytes += level.Size;
+        Record(handle, width, height, compressed_format ? compressed_format : GL_RGBA8, alpha, bytes);
+    }
+
+    void AllocateStorage(TextureHandle handle, int width, int height, AlphaClass alpha) noexcept
+    {
+        if (!Valid(handle)) return;
+
+        View(handle).AllocateStorage(width, height, alpha);
+        Record(handle, width, height, GL_RGBA8, alpha, static_cast<size_t>(width) * height * 4 * 4 / 3);
+    }
+
+    // an invalid handle binds no texture
+    void Bind(TextureHandle handle) const noexcept
+    {
+        glBindTexture(GL_TEXTURE_2D, Name(handle));
+    }
+
+    static void Unbind() noexcept
+    {
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    constexpr unsigned int Name(TextureHandle handle) const noexcept
+    {
+        return Valid(handle) ? m_Slots.get<0>()[Slot(handle)] : 0;
+    }
+
+    // unknown textures are treated as translucent, the pass that draws anything correctly
+    constexpr AlphaClass Alpha(TextureHandle handle) const noexcept
+    {
+        return Valid(handle) ? m_Slots.get<5>()[Slot(handle)] : AlphaClass::Translucent;
+    }
+
+    constexpr int Width(TextureHandle handle) const noexcept
+    {
+        return Valid(handle) ? m_Slots.get<2>()[Slot(handle)] : 0;
+    }
+
+    constexpr int Height(TextureHandle handle) const noexcept
+    {
+        return Valid(handle) ? m_Slots.get<3>()[Slot(handle)] : 0;
+    }
+
+    constexpr GLenum Format(TextureHandle handle) const noexcept
+    {
+        return Valid(handle) ? m_Slots.get<4>()[Slot(handle)] : 0;
+    }
+
+    constexpr size_t Size() const noexcept
+    {
+        return m_Live;
+    }
+
+    // estimated video memory of the live textures, mipmaps included
+    size_t GpuBytes() const noexcept
+    {
+        size_t bytes = 0;
+        for (auto texture_bytes : m_Slots.get<7>()) bytes += texture_bytes;
+        return bytes;
+    }
+
+    // released textures still waiting for the GPU
+    size_t PendingBytes() const noexcept
+    {
+        size_t bytes = 0;
+        for (const auto& grave : m_Graveyard) bytes += grave.Bytes;
+        return bytes;
+    }
+
+private:
+    struct Grave {
+        unsigned int Name;
+        GLsync Fence;
+        size_t Bytes;
+    };
+
+    constexpr static uint32_t Slot(TextureHandle handle) noexcept
+    {
+        return handle & IndexMask;
+    }
+
+    Texture View(TextureHandle handle) const noexcept
+    {
+        return Texture{ m_Slots.get<0>()[Slot(handle)] };
+    }
+
+    void Record(TextureHandle handle, int width, int height, GLenum format, AlphaClass alpha, size_t bytes) noexcept
+    {
+        auto slot = Slot(handle);
+        m_Slots.get<2>()[slot] = width;
+        m_Slots.get<3>()[slot] = height;
+        m_Slots.get<4>()[slot] = format;
+        m_Slots.get<5>()[slot] = alpha;
+        m_Slots.get<7>()[slot] = bytes;
+    }
+
+    // GL name, generation, width, height, format, alpha class, references, bytes
+    core::multivector<unsigned int, uint32_t, int, int, GLenum, AlphaClass, uint32_t, size_t> m_Slots;
+    std::vector<uint32_t> m_FreeSlots;
+    std::vector<Grave> m_Graveyard;
+    size_t m_Live{ 0 };
+};
+
+} // gfx
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "GpuBuffer.h"
+#include "Texture.h"
+#include "TextureRegistry.h"
+
+namespace gfx
+{
+
+/* Uploads textures a few rows at a time, so that loading a level never stalls a frame.
+ * The pixels are copied into a ring of pixel unpack buffers and glTexSubImage2D reads them
+ * from there, asynchronously. Each buffer is guarded by a fence: it is written again only
+ * once the GPU is done with its previous copy.
+ * Enqueue gives the texture its storage right away, it can be bound at once
+ * but shows garbage until Ready says otherwise. Update runs once per frame on the GL thread. */
+class TextureStreamer {
+public:
+    constexpr static size_t SlotCount = 3;
+
+    explicit TextureStreamer(TextureRegistry& textures, size_t slot_bytes = 1 << 20, size_t bytes_per_frame = 4 << 20)
+        : m_Textures{ textures },
+        m_SlotBytes{ slot_bytes },
+        m_BytesPerFrame{ bytes_per_frame }
+    {
+    }
+
+    ~TextureStreamer()
+    {
+        for (auto& slot : m_Slots) {
+            if (slot.Fence) glDeleteSync(slot.Fence);
+        }
+        for (auto& completion : m_Completing) {
+            glDeleteSync(completion.Fence);
+        }
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    void Enqueue(TextureHandle texture, std::unique_ptr<Image> image)
+    {
+        auto alpha = ClassifyAlpha(image->Data, static_cast<size_t>(image->Width) * static_cast<size_t>(image->Height));
+        m_Textures.AllocateStorage(texture, image->Width, image->Height, alpha);
+        // an empty image has no row to upload, the texture is ready as it is
+        if (image->Width <= 0 || image->Height <= 0) return;
+        m_Pending.insert(texture);
+        m_Jobs.push_back(Job{ texture, std::move(image), 0 });
+    }
+
+    // spends at most the per frame budget, and never waits for the GPU
+    void Update()
+    {
+        RetireCompleted();
+
+        size_t budget = m_BytesPerFrame;
+        while (!m_Jobs.empty() && budget > 0) {
+            // released before it finished loading
+            if (!m_Textures.Valid(m_Jobs.front().Texture)) {
+                m_Pending.erase(m_Jobs.front().Texture);
+                m_Jobs.pop_front();
+                continue;
+            }
+
+            // the fence says whether the GPU is done with this buffer: then the driver need not sync again.
+            // when the wait fails nothing is known, the buffer is orphaned and the driver syncs
+            auto& slot = Slot(m_NextSlot);
+            GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+            if (slot.Fence) {
+                auto status = glClientWaitSync(slot.Fence, 0, 0);
+                if (status == GL_TIMEOUT_EXPIRED) break;
+                if (status == GL_WAIT_FAILED) access &= ~GL_MAP_UNSYNCHRONIZED_BIT;
+                glDeleteSync(slot.Fence);
+                slot.Fence = nullptr;
+            }
+
+            auto& job = m_Jobs.front();
+            const size_t row_bytes = static_cast<size_t>(job.Image->Width) * 4;
+            const int rows = static_cast<int>(std::clamp<size_t>(m_SlotBytes / row_bytes, 1, job.Image->Height - job.NextRow));
+            const size_t bytes = rows * row_bytes;
+
+            slot.Buffer.Bind();
+            if (slot.Capacity < bytes) {
+                // rows wider than a slot, the slot grows to fit one
+                slot.Capacity = std::max(m_SlotBytes, bytes);
+                slot.Buffer.Allocate(slot.Capacity, GpuBuffer::Usage::StreamDraw);
+            }
+            auto* mapped = slot.Buffer.Map(0, bytes, access);
+            if (!mapped) {
+                slot.Buffer.Unbind();
+                break;
+            }
+            std::memcpy(mapped, job.Image->Data + job.NextRow * row_bytes, bytes);
+            // the copy was lost (the buffer got corrupted, a mode switch for instance): the rows go again next frame
+            if (!slot.Buffer.Unmap()) {
+                slot.Buffer.Unbind();
+                break;
+            }
+
+            m_Textures.Bind(job.Texture);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job.NextRow, job.Image->Width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            slot.Buffer.Unbind();
+            slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            job.NextRow += rows;
+            bool finished = job.NextRow == job.Image->Height;
+            if (finished) {
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
+            TextureRegistry::Unbind();
+
+            if (finished) {
+                m_Completing.push_back(Completion{ job.Texture, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+                m_Jobs.pop_front();
+            }
+
+            budget -= std::min(budget, bytes);
+            m_NextSlot = (m_NextSlot + 1) % SlotCount;
+        }
+    }
+
+    // all the rows of the texture reached the GPU
+    bool Ready(TextureHandle texture) const noexcept
+    {
+        return !m_Pending.contains(texture);
+    }
+
+    size_t Pending() const noexcept
+    {
+        return m_Pending.size();
+    }
+
+private:
+    struct Job {
+        TextureHandle Texture;
+        std::unique_ptr<gfx::Image> Image;
+        int NextRow;
+    };
+
+    struct Completion {
+        TextureHandle Texture;
+        GLsync Fence;
+    };
+
+    struct PixelBuffer {
+        GpuBuffer Buffer{ GpuBuffer::Target::PixelUnpackBuffer };
+        size_t Capacity{ 0 };
+        GLsync Fence{ nullptr };
+    };
+
+    // the buffers are created on first use, the streamer can be built before the GL context
+    PixelBuffer& Slot(size_t index)
+    {
+        if (m_Slots.empty()) {
+            m_Slots = std::vector<PixelBuffer>(SlotCount);
+        }
+        return m_Slots[index];
+    }
+
+    void RetireCompleted()
+    {
+        std::erase_if(m_Completing, [this](const Completion& completion) {
+            if (glClientWaitSync(completion.Fence, 0, 0) == GL_TIMEOUT_EXPIRED) return false;
+            glDeleteSync(completion.Fence);
+            m_Pending.erase(completion.Texture);
+            return true;
+        });
+    }
+
+    TextureRegistry& m_Textures;
+    size_t m_SlotBytes;
+    size_t m_BytesPerFrame;
+    size_t m_NextSlot{ 0 };
+    std::vector<PixelBuffer> m_Slots;
+    std::deque<Job> m_Jobs;
+    std::vector<Completion> m_Completing;
+    std::unordered_set<TextureHandle> m_Pending;
+};
+
+} // gfx
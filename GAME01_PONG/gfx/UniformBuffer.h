@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "../math/math.h"
+#include "GpuBuffer.h"
+
+namespace gfx
+{
+
+/* Per-frame values shared by every program through the "Frame" uniform block.
+ * The layout must match the std140 declaration in the shaders. */
+struct FrameData {
+    math::Mat<float, 4, 4> Projection;
+    math::Vec2<float> Camera;
+    float Time{ 0.0f };
+    float Padding{ 0.0f };
+};
+
+static_assert(sizeof(FrameData) == 80, "FrameData must follow the std140 layout of the Frame block");
+
+template <typename T>
+class UniformBuffer {
+public:
+    explicit UniformBuffer(GLuint binding)
+        : m_Buffer{ GpuBuffer::Target::UniformBuffer },
+        m_Binding{ binding }
+    {
+    }
+
+    void Allocate() const noexcept
+    {
+        m_Buffer.Bind();
+        m_Buffer.Allocate(sizeof(T), GpuBuffer::Usage::DynamicDraw);
+        m_Buffer.Unbind();
+        m_Buffer.BindBase(m_Binding);
+    }
+
+    void Upload(const T& data) const noexcept
+    {
+        m_Buffer.Bind();
+        m_Buffer.SetData(&data, 1);
+        m_Buffer.Unbind();
+    }
+
+    constexpr GLuint Binding() const noexcept
+    {
+        return m_Binding;
+    }
+
+private:
+    GpuBuffer m_Buffer;
+    GLuint m_Binding;
+};
+
+} // gfx
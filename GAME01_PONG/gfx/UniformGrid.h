@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "../math/math.h"
+
+namespace gfx
+{
+
+/* Spatial index over bboxes: every entry is stored in all the square cells it overlaps,
+ * so a query visits only the cells around the queried area and costs O(entries found)
+ * instead of O(entries stored). Handles are small dense integers, like layer slots.
+ * Entries over more than MaxCellsPerEntry cells, or with a coordinate that is not finite, are kept
+ * in a separate list returned by every query; a query over that many cells returns every entry.
+ * Cell coordinates are clamped to +-MaxCell, the cells at the border hold everything beyond. */
+class UniformGrid {
+public:
+    using Handle = uint32_t;
+
+    constexpr static int32_t MaxCell = 1 << 20;
+    constexpr static int64_t MaxCellsPerEntry = 1024;
+
+    explicit UniformGrid(float cell_size = 256.0f)
+        : m_CellSize{ cell_size }
+    {
+    }
+
+    void Insert(Handle handle, const math::Bbox& bbox)
+    {
+        if (m_Ranges.size() <= handle) {
+            m_Ranges.resize(handle + 1);
+            m_Stamps.resize(handle + 1, 0);
+        }
+
+        auto range = Cells(bbox);
+        if (range.Oversized) {
+            m_Oversized.push_back(handle);
+        } else {
+            for (int32_t y = range.MinY; y <= range.MaxY; ++y) {
+                for (int32_t x = range.MinX; x <= range.MaxX; ++x) {
+                    m_Cells[Key(x, y)].push_back(handle);
+                }
+            }
+        }
+        range.Valid = true;
+        m_Ranges[handle] = range;
+    }
+
+    void Remove(Handle handle)
+    {
+        if (m_Ranges.size() <= handle || !m_Ranges[handle].Valid) return;
+
+        const auto& range = m_Ranges[handle];
+        if (range.Oversized) {
+            Erase(m_Oversized, handle);
+        } else {
+            for (int32_t y = range.MinY; y <= range.MaxY; ++y) {
+                for (int32_t x = range.MinX; x <= range.MaxX; ++x) {
+                    Erase(m_Cells[Key(x, y)], handle);
+                }
+            }
+        }
+        m_Ranges[handle].Valid = false;
+    }
+
+    // moving inside the same cells costs nothing
+    void Update(Handle handle, const math::Bbox& bbox)
+    {
+        if (m_Ranges.size() > handle && m_Ranges[handle].Valid && m_Ranges[handle].SameCells(Cells(bbox))) {
+            return;
+        }
+
+        Remove(handle);
+        Insert(handle, bbox);
+    }
+
+    /* Appends to out every handle stored in the cells overlapping area, each one once.
+     * The candidates still have to be tested against the area. */
+    void Query(const math::Bbox& area, std::vector<Handle>& out)
+    {
+        if (++m_Stamp == 0) {
+            std::fill(m_Stamps.begin(), m_Stamps.end(), 0);
+            m_Stamp = 1;
+        }
+
+        auto range = Cells(area);
+        if (range.Oversized) {
+            for (Handle handle = 0; handle < m_Ranges.size(); ++handle) {
+                if (m_Ranges[handle].Valid) out.push_back(handle);
+            }
+            return;
+        }
+
+        for (int32_t y = range.MinY; y <= range.MaxY; ++y) {
+            for (int32_t x = range.MinX; x <= range.MaxX; ++x) {
+                auto cell = m_Cells.find(Key(x, y));
+                if (cell == m_Cells.end()) continue;
+
+                for (auto handle : cell->second) {
+                    if (m_Stamps[handle] == m_Stamp) continue;
+                    m_Stamps[handle] = m_Stamp;
+                    out.push_back(handle);
+                }
+            }
+        }
+        // stored in no cell, they are in none of the ones visited
+        out.insert(out.end(), m_Oversized.begin(), m_Oversized.end());
+    }
+
+private:
+    struct CellRange {
+        int32_t MinX{ 0 }, MinY{ 0 }, MaxX{ -1 }, MaxY{ -1 };
+        bool Valid{ false };
+        bool Oversized{ false }; // in m_Oversized, the cell coordinates are not used
+
+        constexpr bool SameCells(const CellRange& other) const noexcept
+        {
+            if (Oversized || other.Oversized) return Oversized == other.Oversized;
+            return MinX == other.MinX && MinY == other.MinY && MaxX == other.MaxX && MaxY == other.MaxY;
+        }
+    };
+
+    CellRange Cells(const math::Bbox& bbox) const noexcept
+    {
+        const float x0 = bbox.Pos.x() / m_CellSize, y0 = bbox.Pos.y() / m_CellSize;
+        const float x1 = (bbox.Pos.x() + bbox.Size.x()) / m_CellSize, y1 = (bbox.Pos.y() + bbox.Size.y()) / m_CellSize;
+        if (!std::isfinite(x0) || !std::isfinite(y0) || !std::isfinite(x1) || !std::isfinite(y1)) {
+            return CellRange{ .Oversized = true };
+        }
+
+        CellRange range{
+            .MinX = Cell(x0),
+            .MinY = Cell(y0),
+            .MaxX = Cell(x1),
+            .MaxY = Cell(y1),
+        };
+        const int64_t columns = std::max<int64_t>(int64_t{ range.MaxX } - range.MinX + 1, 0);
+        const int64_t rows = std::max<int64_t>(int64_t{ range.MaxY } - range.MinY + 1, 0);
+        range.Oversized = columns * rows > MaxCellsPerEntry;
+        return range;
+    }
+
+    // a finite coordinate in cells, clamped before the conversion: the float may not fit an int32
+    static int32_t Cell(float coordinate) noexcept
+    {
+        return static_cast<int32_t>(std::clamp(std::floor(coordinate), static_cast<float>(-MaxCell), static_cast<float>(MaxCell)));
+    }
+
+    static void Erase(std::vector<Handle>& handles, Handle handle) noexcept
+    {
+        auto it = std::find(handles.begin(), handles.end(), handle);
+        if (it != handles.end()) {
+            *it = handles.back();
+            handles.pop_back();
+        }
+    }
+
+    static constexpr uint64_t Key(int32_t x, int32_t y) noexcept
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    float m_CellSize;
+    std::unordered_map<uint64_t, std::vector<Handle>> m_Cells;
+    std::vector<Handle> m_Oversized;
+    std::vector<CellRange> m_Ranges;
+    std::vector<uint32_t> m_Stamps;
+    uint32_t m_Stamp{ 0 };
+};
+
+} // gfx
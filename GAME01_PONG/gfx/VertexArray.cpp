@@ -23,10 +23,10 @@ void VertexArray::Unbind() const noexcept
     glBindVertexArray(0);
 }
 
-void VertexArray::SetAttribute(unsigned int index, int size, GLenum type, GLsizei stride, size_t offset) const noexcept
+void VertexArray::SetAttribute(unsigned int index, int size, GLenum type, GLsizei stride, size_t offset, bool normalized) const noexcept
 {
     glEnableVertexAttribArray(index);
-    glVertexAttribPointer(index, size, type, GL_FALSE, stride, reinterpret_cast<void *>(offset));
+    glVertexAttribPointer(index, size, type, normalized ? GL_TRUE : GL_FALSE, stride, reinterpret_cast<void *>(offset));
 }
 
 void VertexArray::DisableAttribute(unsigned int index) const noexcept
@@ -11,7 +11,7 @@ public:
     ~VertexArray();
     void Bind() const noexcept;
     void Unbind() const noexcept;
-    void SetAttribute(unsigned int index, int size, GLenum type, GLsizei stride, size_t offset) const noexcept;
+    void SetAttribute(unsigned int index, int size, GLenum type, GLsizei stride, size_t offset, bool normalized = false) const noexcept;
     void DisableAttribute(unsigned int index) const noexcept;
 
 private:
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "../math/math.h"
+#include "VertexArray.h"
+
+namespace gfx
+{
+
+/* A vertex format describes how a sprite is laid out in the vertex buffer:
+ * the Vertex struct, the attribute layout, the shaders reading it and the function
+ * writing the VerticesPerSprite vertices of a sprite. Quad formats write 4 vertices
+ * (top-left, bottom-left, top-right, bottom-right) drawn as indexed triangles,
+ * point formats write one record expanded by a geometry shader (GeometryShader is null without one).
+ * The renderer takes the format as a template parameter. */
+
+// packs a color in the byte order read by a normalized GL_UNSIGNED_BYTE x4 attribute
+inline uint32_t PackTint(const math::Color& color) noexcept
+{
+    uint32_t rgba = color.ToUint32();
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(rgba >> 24),
+        static_cast<uint8_t>(rgba >> 16),
+        static_cast<uint8_t>(rgba >> 8),
+        static_cast<uint8_t>(rgba)
+    };
+    uint32_t packed;
+    std::memcpy(&packed, bytes, sizeof(packed));
+    return packed;
+}
+
+constexpr uint32_t WhiteTint = 0xffffffffu;
+
+// a coordinate in [0, 1] as read by a normalized GL_UNSIGNED_SHORT attribute, clamped outside
+inline uint16_t PackUnorm16(float value) noexcept
+{
+    return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+#define GFX_FRAME_BLOCK_SOURCE \
+"layout (std140) uniform Frame {\n" \
+"   mat4 projection;\n" \
+"   vec2 camera;\n" \
+"   float time;\n" \
+"};\n"
+
+struct StandardVertex {
+    float X, Y, Z;
+    float U, V;
+    uint32_t Tint;
+};
+
+/* Full precision: float position and depth, float uvs. 24 bytes per vertex. */
+struct StandardVertexFormat {
+    using Vertex = StandardVertex;
+
+    constexpr static GLenum Mode = GL_TRIANGLES;
+    constexpr static size_t VerticesPerSprite = 4;
+    // the smallest depth step the vertex keeps apart: a float keeps 1/128 at the far plane and the
+    // 24 bit depth buffer 1/256, with some margin
+    constexpr static float DepthResolution = 1.0f / 64.0f;
+    constexpr static const char* GeometryShader = nullptr;
+
+    constexpr static const char* VertexShader =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "layout (location = 1) in vec2 uv;\n"
+        "layout (location = 2) in vec4 tint;\n"
+        GFX_FRAME_BLOCK_SOURCE
+        "out vec2 out_uv;\n"
+        "out vec4 out_tint;\n"
+        "void main() {\n"
+        "   gl_Position = projection * vec4(pos.xy - camera, pos.z, 1.0);\n"
+        "   out_uv = uv;\n"
+        "   out_tint = tint;\n"
+        "}\n";
+
+    // expects the vertex buffer to be bound
+    static void SetLayout(const VertexArray& vertex_array)
+    {
+        vertex_array.Bind();
+        vertex_array.SetAttribute(0, 3, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, X));
+        vertex_array.SetAttribute(1, 2, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, U));
+        vertex_array.SetAttribute(2, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), offsetof(Vertex, Tint), true);
+        vertex_array.Unbind();
+    }
+
+    static Vertex* WriteRect(Vertex* out, math::Bbox bbox, float depth, math::Bbox uv, uint32_t tint, math::Vec2<float>) noexcept
+    {
+        const float x0 = bbox.Pos.x(), y0 = bbox.Pos.y();
+        const float x1 = x0 + bbox.Size.x(), y1 = y0 + bbox.Size.y();
+        const float u0 = uv.Pos.x(), v0 = uv.Pos.y();
+        const float u1 = u0 + uv.Size.x(), v1 = v0 + uv.Size.y();
+
+        *out++ = Vertex{ x0, y0, depth, u0, v0, tint };
+        *out++ = Vertex{ x0, y1, depth, u0, v1, tint };
+        *out++ = Vertex{ x1, y0, depth, u1, v0, tint };
+        *out++ = Vertex{ x1, y1, depth, u1, v1, tint };
+        return out;
+    }
+};
+
+struct CompactVertex {
+    int16_t X, Y, Z, Padding;
+    uint16_t U, V;
+    uint32_t Tint;
+};
+
+/* Two thirds of the bandwidth of the standard format, 16 bytes per vertex against 24: positions are whole pixels
+ * in int16 relative to the batch origin (a uniform, the view origin for immediate sprites),
+ * depth is an int16 offset by DepthBias and uvs are unorm16.
+ * Sprites farther than 32767 pixels from the origin are clamped. Depths are rounded to the nearest whole unit,
+ * the renderer's range, -65535 (the farthest layer) to 0 (the nearest automatic depth), is exactly the 65536
+ * values of an int16; depths outside it are clamped. */
+struct CompactVertexFormat {
+    using Vertex = CompactVertex;
+
+    constexpr static GLenum Mode = GL_TRIANGLES;
+    constexpr static size_t VerticesPerSprite = 4;
+    // depths are whole units
+    constexpr static float DepthResolution = 1.0f;
+    constexpr static const char* GeometryShader = nullptr;
+
+    constexpr static float DepthBias = 32767.0f;
+
+    constexpr static const char* VertexShader =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 pos;\n"
+        "layout (location = 1) in vec2 uv;\n"
+        "layout (location = 2) in vec4 tint;\n"
+        GFX_FRAME_BLOCK_SOURCE
+        "uniform vec2 batch_origin;\n"
+        "out vec2 out_uv;\n"
+        "out vec4 out_tint;\n"
+        "void main() {\n"
+        "   vec2 world = pos.xy + batch_origin;\n"
+        "   gl_Position = projection * vec4(world - camera, pos.z - 32767.0, 1.0);\n"
+        "   out_uv = uv;\n"
+        "   out_tint = tint;\n"
+        "}\n";
+
+    static void SetLayout(const VertexArray& vertex_array)
+    {
+        vertex_array.Bind();
+        vertex_array.SetAttribute(0, 3, GL_SHORT, sizeof(Vertex), offsetof(Vertex, X));
+        vertex_array.SetAttribute(1, 2, GL_UNSIGNED_SHORT, sizeof(Vertex), offsetof(Vertex, U), true);
+        vertex_array.SetAttribute(2, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), offsetof(Vertex, Tint), true);
+        vertex_array.Unbind();
+    }
+
+    static Vertex* WriteRect(Vertex* out, math::Bbox bbox, float depth, math::Bbox uv, uint32_t tint, math::Vec2<float> origin) noexcept
+    {
+        const int16_t x0 = Position(bbox.Pos.x() - origin.x());
+        const int16_t y0 = Position(bbox.Pos.y() - origin.y());
+        const int16_t x1 = Position(bbox.Pos.x() + bbox.Size.x() - origin.x());
+        const int16_t y1 = Position(bbox.Pos.y() + bbox.Size.y() - origin.y());
+        const int16_t z = Position(depth + DepthBias);
+        const uint16_t u0 = PackUnorm16(uv.Pos.x()), v0 = PackUnorm16(uv.Pos.y());
+        const uint16_t u1 = PackUnorm16(uv.Pos.x() + uv.Size.x()), v1 = PackUnorm16(uv.Pos.y() + uv.Size.y());
+
+        *out++ = Vertex{ x0, y0, z, 0, u0, v0, tint };
+        *out++ = Vertex{ x0, y1, z, 0, u0, v1, tint };
+        *out++ = Vertex{ x1, y0, z, 0, u1, v0, tint };
+        *out++ = Vertex{ x1, y1, z, 0, u1, v1, tint };
+        return out;
+    }
+
+private:
+    static int16_t Position(float value) noexcept
+    {
+        return static_cast<int16_t>(std::clamp(std::round(value), -32768.0f, 32767.0f));
+    }
+};
+
+struct PointSpriteVertex {
+    float X, Y, W, H;
+    float Z;
+    uint16_t U0, V0, U1, V1;
+    uint32_t Tint;
+};
+
+/* One record per sprite, its bbox, depth, uv rect and tint, drawn as a GL_POINTS and expanded
+ * into a quad by the geometry shader: 32 bytes per sprite against 96 with the standard format,
+ * and the CPU writes a single record instead of 4 vertices. Uvs are unorm16 like the compact format. */
+struct PointSpriteFormat {
+    using Vertex = PointSpriteVertex;
+
+    constexpr static GLenum Mode = GL_POINTS;
+    constexpr static size_t VerticesPerSprite = 1;
+    // a float like the standard format
+    constexpr static float DepthResolution = 1.0f / 64.0f;
+
+    constexpr static const char* VertexShader =
+        "#version 330 core\n"
+        "layout (location = 0) in vec4 rect;\n"
+        "layout (location = 1) in float depth;\n"
+        "layout (location = 2) in vec4 uv_rect;\n"
+        "layout (location = 3) in vec4 tint;\n"
+        "out vec4 sprite_rect;\n"
+        "out float sprite_depth;\n"
+        "out vec4 sprite_uv;\n"
+        "out vec4 sprite_tint;\n"
+        "void main() {\n"
+        "   sprite_rect = rect;\n"
+        "   sprite_depth = depth;\n"
+        "   sprite_uv = uv_rect;\n"
+        "   sprite_tint = tint;\n"
+        "}\n";
+
+    constexpr static const char* GeometryShader =
+        "#version 330 core\n"
+        "layout (points) in;\n"
+        "layout (triangle_strip, max_vertices = 4) out;\n"
+        GFX_FRAME_BLOCK_SOURCE
+        "in vec4 sprite_rect[];\n"
+        "in float sprite_depth[];\n"
+        "in vec4 sprite_uv[];\n"
+        "in vec4 sprite_tint[];\n"
+        "out vec2 out_uv;\n"
+        "out vec4 out_tint;\n"
+        "void corner(vec2 offset) {\n"
+        "   vec2 world = sprite_rect[0].xy + sprite_rect[0].zw * offset;\n"
+        "   gl_Position = projection * vec4(world - camera, sprite_depth[0], 1.0);\n"
+        "   out_uv = mix(sprite_uv[0].xy, sprite_uv[0].zw, offset);\n"
+        "   out_tint = sprite_tint[0];\n"
+        "   EmitVertex();\n"
+        "}\n"
+        "void main() {\n"
+        "   corner(vec2(0.0, 0.0));\n"
+        "   corner(vec2(0.0, 1.0));\n"
+        "   corner(vec2(1.0, 0.0));\n"
+        "   corner(vec2(1.0, 1.0));\n"
+        "   EndPrimitive();\n"
+        "}\n";
+
+    static void SetLayout(const VertexArray& vertex_array)
+    {
+        vertex_array.Bind();
+        vertex_array.SetAttribute(0, 4, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, X));
+        vertex_array.SetAttribute(1, 1, GL_FLOAT, sizeof(Vertex), offsetof(Vertex, Z));
+        vertex_array.SetAttribute(2, 4, GL_UNSIGNED_SHORT, sizeof(Vertex), offsetof(Vertex, U0), true);
+        vertex_array.SetAttribute(3, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), offsetof(Vertex, Tint), true);
+        vertex_array.Unbind();
+    }
+
+    static Vertex* WriteRect(Vertex* out, math::Bbox bbox, float depth, math::Bbox uv, uint32_t tint, math::Vec2<float>) noexcept
+    {
+        *out++ = Vertex{
+            bbox.Pos.x(), bbox.Pos.y(), bbox.Size.x(), bbox.Size.y(),
+            depth,
+            PackUnorm16(uv.Pos.x()), PackUnorm16(uv.Pos.y()), PackUnorm16(uv.Pos.x() + uv.Size.x()), PackUnorm16(uv.Pos.y() + uv.Size.y()),
+            tint
+        };
+        return out;
+    }
+};
+
+static_assert(sizeof(StandardVertex) == 24);
+static_assert(sizeof(CompactVertex) == 16);
+static_assert(sizeof(PointSpriteVertex) == 32);
+
+#undef GFX_FRAME_BLOCK_SOURCE
+
+} // gfx
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_VERTEX_WRITER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "../math/math.h"
+#include "VertexFormat.h"
+
+namespace gfx
+{
+
+/* The columns of a SpriteStorage the vertices are made of, sprite i is element i of each. */
+struct RectColumns {
+    const math::Vec2<float>* Positions;
+    const math::Vec2<float>* Sizes;
+    const float* Depths;
+    const math::Bbox* Uvs;
+    const uint32_t* Tints;
+};
+
+/* Writes the vertices of sprites [begin, end) from the columns, returns the end of what was written.
+ * Any format works through its WriteRect, the formats with a vectorized writer get it below. */
+template <typename VertexFormat>
+struct VertexWriter {
+    using Vertex = typename VertexFormat::Vertex;
+
+    static Vertex* WriteRects(Vertex* out, const RectColumns& rects, size_t begin, size_t end, math::Vec2<float> origin) noexcept
+    {
+        for (size_t i = begin; i < end; ++i) {
+            out = VertexFormat::WriteRect(out, math::Bbox{ rects.Positions[i], rects.Sizes[i] }, rects.Depths[i], rects.Uvs[i], rects.Tints[i], origin);
+        }
+        return out;
+    }
+};
+
+#ifdef GFX_VERTEX_WRITER_SSE2
+
+/* The 4 standard vertices of a sprite are 24 floats, 6 SSE registers built with shuffles
+ * from (x0, y0, x1, y1), (u0, v0, u1, v1), the depth and the tint, two sprites per load of the columns.
+ * Big outputs are written with streaming stores: they would only evict the cache on their way
+ * to the upload, the driver reads them once. Same bits as StandardVertexFormat::WriteRect. */
+template <>
+struct VertexWriter<StandardVertexFormat> {
+    using Vertex = StandardVertex;
+
+    // below this the output likely stays in cache until the upload, regular stores are faster
+    constexpr static size_t StreamingBytes = 256 * 1024;
+
+    static Vertex* WriteRects(Vertex* out, const RectColumns& rects, size_t begin, size_t end, math::Vec2<float>) noexcept
+    {
+        static_assert(sizeof(math::Vec2<float>) == 2 * sizeof(float));
+        static_assert(sizeof(math::Bbox) == 4 * sizeof(float));
+        static_assert(sizeof(Vertex) * 4 == 6 * sizeof(__m128));
+
+        bool aligned = reinterpret_cast<uintptr_t>(out) % alignof(__m128) == 0;
+        bool streaming = aligned && (end - begin) * 4 * sizeof(Vertex) >= StreamingBytes;
+        auto* dst = reinterpret_cast<float*>(out);
+        auto* positions = reinterpret_cast<const float*>(rects.Positions);
+        auto* sizes = reinterpret_cast<const float*>(rects.Sizes);
+
+        size_t i = begin;
+        for (; i + 2 <= end; i += 2) {
+            // (x, y) of two sprites per register, the max corners with one add
+            __m128 pos = _mm_loadu_ps(positions + 2 * i);
+            __m128 max = _mm_add_ps(pos, _mm_loadu_ps(sizes + 2 * i));
+            __m128 first = _mm_movelh_ps(pos, max);
+            __m128 second = _mm_movehl_ps(max, pos);
+
+            Store(dst, first, i, rects, streaming);
+            Store(dst + 24, second, i + 1, rects, streaming);
+            dst += 48;
+        }
+        if (i < end) {
+            __m128 pos = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(positions + 2 * i)));
+            __m128 size = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(sizes + 2 * i)));
+            Store(dst, _mm_movelh_ps(pos, _mm_add_ps(pos, size)), i, rects, streaming);
+            dst += 24;
+        }
+
+        // streaming stores are weakly ordered, they must land before the upload reads them
+        if (streaming) _mm_sfence();
+        return reinterpret_cast<Vertex*>(dst);
+    }
+
+private:
+    // rect is (x0, y0, x1, y1) of sprite i
+    static void Store(float* dst, __m128 rect, size_t i, const RectColumns& rects, bool streaming) noexcept
+    {
+        __m128 uv = _mm_loadu_ps(reinterpret_cast<const float*>(rects.Uvs + i));
+        __m128 uv_rect = _mm_movelh_ps(uv, _mm_add_ps(uv, _mm_movehl_ps(uv, uv))); // (u0, v0, u1, v1)
+        __m128 depth = _mm_set1_ps(rects.Depths[i]);
+        __m128 tint = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(rects.Tints[i])));
+
+        __m128 zu = _mm_unpacklo_ps(depth, _mm_shuffle_ps(uv_rect, uv_rect, _MM_SHUFFLE(2, 0, 2, 0))); // (z, u0, z, u1)
+        __m128 vt = _mm_unpacklo_ps(_mm_shuffle_ps(uv_rect, uv_rect, _MM_SHUFFLE(3, 1, 3, 1)), tint); // (v0, t, v1, t)
+
+        // x0 y0 z u0 | v0 t x0 y1 | z u0 v1 t | x1 y0 z u1 | v0 t x1 y1 | z u1 v1 t
+        __m128 out[6] = {
+            _mm_shuffle_ps(rect, zu, _MM_SHUFFLE(1, 0, 1, 0)),
+            _mm_shuffle_ps(vt, rect, _MM_SHUFFLE(3, 0, 1, 0)),
+            _mm_shuffle_ps(zu, vt, _MM_SHUFFLE(3, 2, 1, 0)),
+            _mm_shuffle_ps(rect, zu, _MM_SHUFFLE(3, 2, 1, 2)),
+            _mm_shuffle_ps(vt, rect, _MM_SHUFFLE(3, 2, 1, 0)),
+            _mm_shuffle_ps(zu, vt, _MM_SHUFFLE(3, 2, 3, 2)),
+        };
+
+        if (streaming) {
+            for (int k = 0; k < 6; ++k) _mm_stream_ps(dst + 4 * k, out[k]);
+        } else {
+            for (int k = 0; k < 6; ++k) _mm_storeu_ps(dst + 4 * k, out[k]);
+        }
+    }
+};
+
+#endif
+
+} // gfx
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "Animator.h"
+#include "FrameCapture.h"
 #include "Sprite.h"
+#include "SpriteSheet.h"
 #include "Renderer.h"
+#include "SoftwareRasterizer.h"
 #include "Texture.h"
+#include "TextureRegistry.h"
 
 namespace gfx
 {
@@ -0,0 +1,131 @@
+/* Retained layers and their uniform grid, on a RecordingBackend: no GPU or window needed.
+ * The exit code is 1 when a check fails, each failure is printed. Built with the game sources but Main.cpp. */
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "../gfx/RecordingBackend.h"
+#include "../gfx/SpriteLayer.h"
+#include "../gfx/UniformGrid.h"
+
+namespace
+{
+
+int failures = 0;
+
+void Expect(bool condition, const char* what)
+{
+    if (!condition) {
+        std::printf("FAIL %s\n", what);
+        failures++;
+    }
+}
+
+const math::Bbox View{ 0.0f, 0.0f, 1280.0f, 720.0f };
+
+// a removed sprite stays out of the layer whatever is done with its handle
+void RemovedHandleIsIgnored()
+{
+    gfx::TextureRegistry textures;
+    gfx::SpriteLayer<> layer{ textures, -1.0f };
+    gfx::Sprite sprite{ math::Bbox{ 0.0f, 0.0f, 8.0f, 8.0f }, textures.Create() };
+    layer.Add(sprite);
+    auto removed = layer.Add(sprite);
+    layer.Add(sprite);
+    layer.Remove(removed);
+    sprite.Bbox.Pos = math::Vec2<float>{ 16.0f, 16.0f };
+    layer.Update(removed, sprite);
+    layer.SetPosition(removed, math::Vec2<float>{ 32.0f, 32.0f });
+    layer.Sync(View);
+
+    Expect(layer.Size() == 2, "removed handle: 2 sprites left");
+    Expect(layer.VisibleCount() == 2, "removed handle: 2 sprites visible");
+}
+
+// a texture stays valid while a live sprite of a layer uses it, whoever else releases it
+void LayerHoldsTextures()
+{
+    gfx::TextureRegistry textures;
+    auto first = textures.Create();
+    auto second = textures.Create();
+    {
+        gfx::SpriteLayer<> layer{ textures, -1.0f };
+        gfx::Sprite sprite{ math::Bbox{ 0.0f, 0.0f, 8.0f, 8.0f }, first };
+        auto handle = layer.Add(sprite);
+        layer.Add(gfx::Sprite{ sprite.Bbox, second });
+        textures.Release(first);
+        textures.Release(second);
+        Expect(textures.Valid(first) && textures.Valid(second), "layer: textures of live sprites kept");
+
+        sprite.Texture = second;
+        layer.Update(handle, sprite);
+        Expect(!textures.Valid(first), "layer: previous texture released on update");
+        layer.Remove(handle);
+        Expect(textures.Valid(second), "layer: texture still used by another sprite");
+    }
+    Expect(!textures.Valid(second), "layer: textures released with the layer");
+}
+
+// handles have 20 bits of index, the registry refuses to alias them
+void RegistryCapacity()
+{
+    gfx::TextureRegistry textures;
+    for (uint32_t i = 0; i <= gfx::TextureRegistry::IndexMask; ++i) textures.Create();
+    bool thrown = false;
+    try {
+        textures.Create();
+    } catch (const std::length_error&) {
+        thrown = true;
+    }
+    Expect(thrown, "registry: no slot past the handle index");
+}
+
+// sprites far away, huge or not finite still come out of a query, the ones out of view do not
+void GridEdgeCases()
+{
+    gfx::UniformGrid grid{ 256.0f };
+    const float infinity = std::numeric_limits<float>::infinity();
+    grid.Insert(0, math::Bbox{ 10.0f, 10.0f, 8.0f, 8.0f });
+    grid.Insert(1, math::Bbox{ -1e30f, -1e30f, 2e30f, 2e30f }); // over every cell
+    grid.Insert(2, math::Bbox{ std::nanf(""), 0.0f, 8.0f, 8.0f });
+    grid.Insert(3, math::Bbox{ 0.0f, 0.0f, infinity, 8.0f });
+    grid.Insert(4, math::Bbox{ 3e38f, 3e38f, 8.0f, 8.0f }); // past the last cell, clamped to it
+    grid.Insert(5, math::Bbox{ 5000.0f, 5000.0f, 8.0f, 8.0f });
+
+    std::vector<gfx::UniformGrid::Handle> found;
+    grid.Query(View, found);
+    std::vector<bool> in(6, false);
+    for (auto handle : found) in[handle] = true;
+    Expect(found.size() == 4, "grid: 4 candidates in view");
+    Expect(in[0] && in[1] && in[2] && in[3], "grid: the entry in view and the oversized ones");
+    Expect(!in[4] && !in[5], "grid: no entry out of view");
+
+    found.clear();
+    grid.Query(math::Bbox{ -1e9f, -1e9f, 2e9f, 2e9f }, found);
+    Expect(found.size() == 6, "grid: a query over too many cells returns every entry");
+
+    grid.Remove(1);
+    grid.Remove(2);
+    grid.Update(3, math::Bbox{ 5000.0f, 5000.0f, 8.0f, 8.0f });
+    found.clear();
+    grid.Query(View, found);
+    Expect(found.size() == 1 && found[0] == 0, "grid: oversized entries removed and moved");
+}
+
+}
+
+int main()
+{
+    gfx::RecordingBackend backend{ gfx::RecordingBackend::Mode::Null };
+    RemovedHandleIsIgnored();
+    LayerHoldsTextures();
+    RegistryCapacity();
+    GridEdgeCases();
+    if (failures == 0) {
+        std::printf("all checks passed\n");
+    }
+    return failures ? 1 : 0;
+}
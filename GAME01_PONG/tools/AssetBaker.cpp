@@ -0,0 +1,361 @@
+/* Offline baker of asset packs (see AssetPackFormat.h).
+ *
+ *   AssetBaker <output.pack> [--bc] <image>[:<frames.json> | :<width>x<height>]...
+ *
+ * Every image is decoded once here, its mip chain is built on the CPU and, with --bc,
+ * compressed to BC1 (opaque) or BC3 (with alpha). A frame list or a grid size after
+ * the image name is baked as the atlas frames of the texture.
+ * Run from the game directory so that the names match the paths the game asks for. */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "../AssetPackFormat.h"
+#include "../FrameList.h"
+#include "../gfx/Texture.h"
+
+namespace
+{
+
+using namespace fs;
+
+struct Level {
+    uint32_t Width;
+    uint32_t Height;
+    std::vector<uint8_t> Data;
+};
+
+struct BakedTexture {
+    std::string Name;
+    pack::PixelFormat Format;
+    gfx::AlphaClass Alpha;
+    std::vector<Level> Levels;
+    std::vector<pack::Frame> Frames;
+};
+
+// 2x2 box filter, the last row or column is repeated for odd sizes
+Level Downsample(const Level& source)
+{
+    Level level{ std::max(source.Width / 2, 1u), std::max(source.Height / 2, 1u), {} };
+    level.Data.resize(size_t{ level.Width } * level.Height * 4);
+    for (uint32_t y = 0; y < level.Height; ++y) {
+        for (uint32_t x = 0; x < level.Width; ++x) {
+            uint32_t x0 = std::min(x * 2, source.Width - 1), x1 = std::min(x * 2 + 1, source.Width - 1);
+            uint32_t y0 = std::min(y * 2, source.Height - 1), y1 = std::min(y * 2 + 1, source.Height - 1);
+            for (uint32_t c = 0; c < 4; ++c) {
+                auto at = [&source, c](uint32_t sx, uint32_t sy) {
+                    return uint32_t{ source.Data[(size_t{ sy } * source.Width + sx) * 4 + c] };
+                };
+                uint32_t sum = at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1);
+                level.Data[(size_t{ y } * level.Width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return level;
+}
+
+uint16_t To565(const uint8_t* rgb) noexcept
+{
+    return static_cast<uint16_t>(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+void From565(uint16_t color, int* rgb) noexcept
+{
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+void Write16(uint8_t* out, uint16_t value) noexcept
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+/* Color endpoints from the bounding box of the block, always in the 4 colors mode. */
+void EncodeColorBlock(const uint8_t (&texels)[16][4], uint8_t* out) noexcept
+{
+    uint8_t low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+    for (const auto& texel : texels) {
+        for (int c = 0; c < 3; ++c) {
+            low[c] = std::min(low[c], texel[c]);
+            high[c] = std::max(high[c], texel[c]);
+        }
+    }
+
+    uint16_t c0 = To565(high), c1 = To565(low);
+    if (c0 < c1) std::swap(c0, c1);
+    Write16(out, c0);
+    Write16(out + 2, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        From565(c0, palette[0]);
+        From565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, best_distance = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = texels[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (i * 2);
+        }
+    }
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+/* Alpha endpoints are the extremes of the block, 8 interpolated values. */
+void EncodeAlphaBlock(const uint8_t (&texels)[16][4], uint8_t* out) noexcept
+{
+    uint8_t a0 = 0, a1 = 255;
+    for (const auto& texel : texels) {
+        a0 = std::max(a0, texel[3]);
+        a1 = std::min(a1, texel[3]);
+    }
+    out[0] = a0;
+    out[1] = a1;
+
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        int palette[8] = { a0, a1 };
+        for (int p = 1; p < 7; ++p) {
+            palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, best_distance = 256;
+            for (int p = 0; p < 8; ++p) {
+                int distance = std::abs(texels[i][3] - palette[p]);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (i * 3);
+        }
+    }
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+}
+
+Level Compress(const Level& level, pack::PixelFormat format)
+{
+    Level compressed{ level.Width, level.Height, {} };
+    compressed.Data.resize(pack::LevelSize(format, level.Width, level.Height));
+    size_t block_size = format == pack::PixelFormat::BC1 ? 8 : 16;
+
+    uint8_t* out = compressed.Data.data();
+    for (uint32_t by = 0; by < level.Height; by += 4) {
+        for (uint32_t bx = 0; bx < level.Width; bx += 4) {
+            // blocks crossing the border repeat the last texels
+            uint8_t texels[16][4];
+            for (uint32_t i = 0; i < 16; ++i) {
+                uint32_t x = std::min(bx + i % 4, level.Width - 1);
+                uint32_t y = std::min(by + i / 4, level.Height - 1);
+                std::memcpy(texels[i], &level.Data[(size_t{ y } * level.Width + x) * 4], 4);
+            }
+
+            if (format == pack::PixelFormat::BC3) {
+                EncodeAlphaBlock(texels, out);
+                EncodeColorBlock(texels, out + 8);
+            } else {
+                EncodeColorBlock(texels, out);
+            }
+            out += block_size;
+        }
+    }
+    return compressed;
+}
+
+std::vector<pack::Frame> ReadFrames(std::string_view spec, uint32_t width, uint32_t height)
+{
+    std::vector<pack::Frame> frames;
+    int frame_width = 0, frame_height = 0;
+    if (std::sscanf(std::string{ spec }.c_str(), "%dx%d", &frame_width, &frame_height) == 2 && frame_width > 0 && frame_height > 0) {
+        for (uint32_t y = 0; y + frame_height <= height; y += frame_height) {
+            for (uint32_t x = 0; x + frame_width <= width; x += frame_width) {
+                frames.push_back({ float(x), float(y), float(frame_width), float(frame_height) });
+            }
+        }
+        return frames;
+    }
+
+    std::ifstream file{ std::string{ spec } };
+    if (!file) {
+        std::cerr << "Could not load frame list " << spec << std::endl;
+        std::exit(37);
+    }
+    std::stringstream json;
+    json << file.rdbuf();
+    for (const auto& frame : ParseFrameList(json.str())) {
+        frames.push_back({ frame.Pos.x(), frame.Pos.y(), frame.Size.x(), frame.Size.y() });
+    }
+    return frames;
+}
+
+BakedTexture Bake(std::string_view argument, bool compress)
+{
+    auto separator = argument.find(':', argument.size() > 2 && argument[1] == ':' ? 2 : 0);
+    std::string path{ argument.substr(0, separator) };
+
+    int width, height, components;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &components, 4);
+    if (pixels == nullptr) {
+        std::cerr << "Could not load image " << path << std::endl;
+        std::exit(37);
+    }
+    if (uint32_t(width) > pack::MaxDimension || uint32_t(height) > pack::MaxDimension) {
+        std::cerr << "Image " << path << " is larger than " << pack::MaxDimension << " pixels" << std::endl;
+        std::exit(37);
+    }
+
+    BakedTexture texture;
+    texture.Name = std::filesystem::path{ path }.lexically_normal().generic_string();
+    texture.Alpha = gfx::ClassifyAlpha(pixels, size_t(width) * size_t(height));
+    texture.Format = !compress ? pack::PixelFormat::RGBA8
+        : texture.Alpha == gfx::AlphaClass::Opaque ? pack::PixelFormat::BC1 : pack::PixelFormat::BC3;
+
+    texture.Levels.push_back(Level{ uint32_t(width), uint32_t(height), { pixels, pixels + size_t(width) * height * 4 } });
+    stbi_image_free(pixels);
+    while (texture.Levels.size() < pack::MaxMips && (texture.Levels.back().Width > 1 || texture.Levels.back().Height > 1)) {
+        texture.Levels.push_back(Downsample(texture.Levels.back()));
+    }
+
+    if (texture.Format != pack::PixelFormat::RGBA8) {
+        for (auto& level : texture.Levels) {
+            level = Compress(level, texture.Format);
+        }
+    }
+
+    if (separator != std::string_view::npos) {
+        texture.Frames = ReadFrames(argument.substr(separator + 1), uint32_t(width), uint32_t(height));
+    }
+    return texture;
+}
+
+bool WritePack(const char* output, const std::vector<BakedTexture>& textures)
+{
+    pack::Header header{};
+    header.Magic = pack::Magic;
+    header.Version = pack::Version;
+    header.EntryCount = static_cast<uint32_t>(textures.size());
+    header.EntriesOffset = sizeof(pack::Header);
+
+    std::vector<pack::Frame> frames;
+    for (const auto& texture : textures) {
+        frames.insert(frames.end(), texture.Frames.begin(), texture.Frames.end());
+    }
+    header.FrameCount = static_cast<uint32_t>(frames.size());
+    header.FramesOffset = header.EntriesOffset + textures.size() * sizeof(pack::Entry);
+    header.NamesOffset = header.FramesOffset + frames.size() * sizeof(pack::Frame);
+
+    std::vector<pack::Entry> entries(textures.size());
+    uint64_t name_offset = header.NamesOffset;
+    uint32_t first_frame = 0;
+    for (size_t i = 0; i < textures.size(); ++i) {
+        const auto& texture = textures[i];
+        auto& entry = entries[i];
+        entry.NameOffset = name_offset;
+        entry.NameLength = static_cast<uint32_t>(texture.Name.size());
+        entry.Format = texture.Format;
+        entry.Width = texture.Levels[0].Width;
+        entry.Height = texture.Levels[0].Height;
+        entry.MipCount = static_cast<uint32_t>(texture.Levels.size());
+        entry.FirstFrame = first_frame;
+        entry.FrameCount = static_cast<uint32_t>(texture.Frames.size());
+        entry.Alpha = static_cast<uint32_t>(texture.Alpha);
+        name_offset += texture.Name.size();
+        first_frame += entry.FrameCount;
+    }
+
+    uint64_t data_offset = pack::AlignUp(name_offset);
+    for (size_t i = 0; i < textures.size(); ++i) {
+        for (size_t level = 0; level < textures[i].Levels.size(); ++level) {
+            entries[i].MipOffsets[level] = data_offset;
+            entries[i].MipSizes[level] = static_cast<uint32_t>(textures[i].Levels[level].Data.size());
+            data_offset = pack::AlignUp(data_offset + textures[i].Levels[level].Data.size());
+        }
+    }
+
+    std::ofstream file{ output, std::ios::binary | std::ios::trunc };
+    if (!file) return false;
+
+    auto pad_to = [&file](uint64_t offset) {
+        static const char zeros[pack::DataAlignment]{};
+        auto position = static_cast<uint64_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(offset - position));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(pack::Entry)));
+    file.write(reinterpret_cast<const char*>(frames.data()), static_cast<std::streamsize>(frames.size() * sizeof(pack::Frame)));
+    for (const auto& texture : textures) {
+        file.write(texture.Name.data(), static_cast<std::streamsize>(texture.Name.size()));
+    }
+    for (size_t i = 0; i < textures.size(); ++i) {
+        for (size_t level = 0; level < textures[i].Levels.size(); ++level) {
+            pad_to(entries[i].MipOffsets[level]);
+            const auto& data = textures[i].Levels[level].Data;
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <output.pack> [--bc] <image>[:<frames.json> | :<width>x<height>]..." << std::endl;
+        return 1;
+    }
+
+    bool compress = false;
+    std::vector<BakedTexture> textures;
+    for (int i = 2; i < argc; ++i) {
+        std::string_view argument{ argv[i] };
+        if (argument == "--bc") {
+            compress = true;
+            continue;
+        }
+        textures.push_back(Bake(argument, compress));
+        std::cout << "baked " << textures.back().Name << ": " << textures.back().Levels.size() << " levels, "
+            << textures.back().Frames.size() << " frames" << std::endl;
+    }
+
+    if (!WritePack(argv[1], textures)) {
+        std::cerr << "Could not write " << argv[1] << std::endl;
+        return 37;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/* The software rasterizer on a scene of sprites, on one thread and on a pool.
+ *
+ *   RasterBench [sprites] [frames] [output.png]
+ *
+ * Half the sprites are opaque with a checker texture, the other half translucent and tinted,
+ * over a 1280x720 framebuffer. The frame drawn on the pool must be the one drawn on the calling thread,
+ * byte for byte, the exit code is 1 when it is not. The last frame goes to output.png when given.
+ * Needs no GL context. Built with the game sources but Main.cpp. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <stb_image_write.h>
+
+#include "../gfx/SoftwareRasterizer.h"
+
+namespace
+{
+
+constexpr int Width = 1280;
+constexpr int Height = 720;
+constexpr size_t BatchSprites = 4096;
+constexpr gfx::TextureHandle Checker = 1;
+constexpr gfx::TextureHandle Glass = 2;
+
+struct Scene {
+    std::vector<math::Vec2<float>> Positions;
+    std::vector<math::Vec2<float>> Sizes;
+    std::vector<float> Depths;
+    std::vector<math::Color> Tints;
+};
+
+Scene MakeScene(size_t sprite_count)
+{
+    std::mt19937 random{ 37 };
+    std::uniform_real_distribution<float> x{ -16.0f, Width };
+    std::uniform_real_distribution<float> y{ -16.0f, Height };
+    std::uniform_real_distribution<float> size{ 4.0f, 48.0f };
+    std::uniform_real_distribution<float> depth{ -60000.0f, -1.0f };
+    std::uniform_real_distribution<float> channel{ 0.0f, 1.0f };
+
+    Scene scene;
+    for (size_t i = 0; i < sprite_count; ++i) {
+        scene.Positions.push_back(math::Vec2<float>{ x(random), y(random) });
+        scene.Sizes.push_back(math::Vec2<float>{ size(random), size(random) });
+        scene.Depths.push_back(depth(random));
+        scene.Tints.push_back(math::Color{ channel(random), channel(random), channel(random), channel(random) });
+    }
+    return scene;
+}
+
+void SetTextures(gfx::SoftwareRasterizer& rasterizer)
+{
+    std::vector<unsigned char> checker(8 * 8 * 4);
+    for (int i = 0; i < 8 * 8; ++i) {
+        unsigned char value = ((i % 8) / 2 + (i / 8) / 2) % 2 ? 0xff : 0x40;
+        checker[4 * i + 0] = value;
+        checker[4 * i + 1] = value;
+        checker[4 * i + 2] = 0x80;
+        checker[4 * i + 3] = 0xff;
+    }
+    rasterizer.SetTexture(Checker, 8, 8, checker.data());
+
+    std::vector<unsigned char> glass(4 * 4 * 4, 0xff);
+    rasterizer.SetTexture(Glass, 4, 4, glass.data());
+}
+
+// returns the mean time of a frame in milliseconds
+double Run(gfx::SoftwareRasterizer& rasterizer, const Scene& scene, int frames)
+{
+    SetTextures(rasterizer);
+    gfx::SpriteStorage<BatchSprites> sprites;
+    std::span<const math::Vec2<float>> positions{ scene.Positions };
+    std::span<const math::Vec2<float>> sizes{ scene.Sizes };
+    std::span<const float> depths{ scene.Depths };
+    size_t half = positions.size() / 2;
+    const math::Bbox view{ math::Vec2<float>{ 0.0f, 0.0f }, math::Vec2<float>{ Width, Height } };
+
+    using clock = std::chrono::steady_clock;
+    double total_ms = 0.0;
+    for (int frame = 0; frame < frames; ++frame) {
+        sprites.AddSprites(positions.first(half), sizes.first(half), Checker, gfx::RenderPass::Opaque, gfx::DefaultMaterial, depths.first(half), 0.0f);
+        sprites.AddSprites(positions.subspan(half), sizes.subspan(half), Glass, gfx::RenderPass::Translucent, gfx::DefaultMaterial,
+            depths.subspan(half), 0.0f, {}, std::span<const math::Color>{ scene.Tints }.subspan(half));
+
+        auto start = clock::now();
+        rasterizer.Clear(math::Color{ 0.1f, 0.1f, 0.2f, 1.0f });
+        rasterizer.Draw(sprites, view);
+        total_ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        sprites.Clear();
+    }
+    return total_ms / frames;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t sprite_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+    const char* output = argc > 3 ? argv[3] : nullptr;
+
+    auto scene = MakeScene(sprite_count);
+    core::ThreadPool workers;
+
+    gfx::SoftwareRasterizer serial{ Width, Height };
+    gfx::SoftwareRasterizer parallel{ Width, Height, &workers };
+    double serial_ms = Run(serial, scene, frames);
+    double parallel_ms = Run(parallel, scene, frames);
+
+    std::printf("%zu sprites, %zu tiles drawn\n", sprite_count, parallel.TilesDrawn());
+    std::printf("   1 thread   %8.3f ms\n", serial_ms);
+    std::printf("  %2zu threads  %8.3f ms\n", workers.Size() + 1, parallel_ms);
+
+    bool same = serial.Pixels() == parallel.Pixels();
+    if (!same) {
+        std::printf("  FAIL the frames of 1 and %zu threads differ\n", workers.Size() + 1);
+    }
+    if (output && !stbi_write_png(output, Width, Height, 4, parallel.Pixels().data(), Width * 4)) {
+        std::printf("  could not write %s\n", output);
+    }
+    return same ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+/* The CPU side of Renderer::Flush, without a GPU or a window, on a RecordingBackend.
+ *
+ *   RendererBench [max sprites] [frames]
+ *
+ * Every frame submits the same sprites, half opaque and half translucent, and flushes them.
+ * The scene goes from 1000 sprites to max sprites (1000000 by default) by factors of 10.
+ * The counts are deterministic, so they are also checked: the exit code is 1 when the draw calls
+ * or the state changes of a frame go past what the scene needs, a regression to look at.
+ * Built with the game sources but Main.cpp. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "../Platform.h"
+#include "../gfx/RecordingBackend.h"
+#include "../gfx/Renderer.h"
+
+namespace
+{
+
+constexpr size_t BatchSprites = 4096;
+using Format = gfx::StandardVertexFormat;
+using BenchRenderer = gfx::Renderer<BatchSprites, Format>;
+
+/* The budgets the checks hold the renderer to. One texture and one material per pass,
+ * so one draw per batch; the state set per batch is the pass state, the buffer and the texture. */
+constexpr size_t MaxDrawCallsPerBatch = 1;
+constexpr size_t MaxFixedStateChanges = 32; // the frame setup: target, viewport, clear, frame uniforms
+constexpr size_t MaxStateChangesPerBatch = 8;
+
+struct Result {
+    double FlushMs;
+    gfx::RendererStats Stats;
+    gfx::GlCounters Gl; // of the last frame
+};
+
+gfx::TextureHandle SolidTexture(gfx::TextureRegistry& textures, unsigned char alpha)
+{
+    auto texture = textures.Create();
+    auto pixels = static_cast<unsigned char*>(std::malloc(4 * 4 * 4));
+    for (int i = 0; i < 4 * 4; ++i) {
+        pixels[4 * i + 0] = 0xff;
+        pixels[4 * i + 1] = 0xff;
+        pixels[4 * i + 2] = 0xff;
+        pixels[4 * i + 3] = alpha;
+    }
+    textures.Allocate(texture, gfx::Image{ 4, 4, pixels });
+    return texture;
+}
+
+Result Run(gfx::RecordingBackend& backend, size_t sprite_count, int frames)
+{
+    constexpr int width = 1280;
+    constexpr int height = 720;
+
+    gfx::TextureRegistry textures;
+    BenchRenderer renderer{ width, height, textures };
+    renderer.Init();
+    auto opaque = SolidTexture(textures, 0xff);
+    auto translucent = SolidTexture(textures, 0x80);
+
+    std::mt19937 random{ 37 };
+    std::uniform_real_distribution<float> x{ 0.0f, width - 8.0f };
+    std::uniform_real_distribution<float> y{ 0.0f, height - 8.0f };
+    std::vector<math::Vec2<float>> positions;
+    for (size_t i = 0; i < sprite_count; ++i) {
+        positions.push_back(math::Vec2<float>{ x(random), y(random) });
+    }
+    std::vector<math::Vec2<float>> sizes(sprite_count, math::Vec2<float>{ 8.0f, 8.0f });
+    std::span<const math::Vec2<float>> all_positions{ positions };
+    std::span<const math::Vec2<float>> all_sizes{ sizes };
+    size_t half = sprite_count / 2;
+
+    using clock = std::chrono::steady_clock;
+    constexpr int warmup = 3;
+    double flush_ms = 0.0;
+    for (int frame = 0; frame < warmup + frames; ++frame) {
+        backend.Reset();
+        auto start = clock::now();
+        renderer.Clear();
+        renderer.DrawSprites(all_positions.first(half), all_sizes.first(half), opaque);
+        renderer.DrawSprites(all_positions.subspan(half), all_sizes.subspan(half), translucent);
+        renderer.Flush();
+        auto flushed = clock::now();
+
+        if (frame < warmup) continue;
+        flush_ms += std::chrono::duration<double, std::milli>(flushed - start).count();
+    }
+
+    Result result{ flush_ms / frames, renderer.Stats(), backend.Counters() };
+    textures.Release(opaque);
+    textures.Release(translucent);
+    return result;
+}
+
+// prints what is wrong, returns false when something is
+bool Check(size_t sprite_count, const Result& result)
+{
+    bool ok = true;
+    const auto& stats = result.Stats;
+    const auto& gl = result.Gl;
+    auto fail = [&](const char* what, size_t value, size_t limit) {
+        std::printf("  FAIL %zu sprites: %s %zu, expected %zu\n", sprite_count, what, value, limit);
+        ok = false;
+    };
+
+    if (gl.DrawCalls != stats.DrawCalls) fail("GL draw calls", gl.DrawCalls, stats.DrawCalls);
+    if (stats.DrawCalls > stats.Batches * MaxDrawCallsPerBatch) fail("draw calls", stats.DrawCalls, stats.Batches * MaxDrawCallsPerBatch);
+
+    size_t state_changes = gl.StateChanges + gl.Binds + gl.ProgramSwitches;
+    size_t state_budget = MaxFixedStateChanges + stats.Batches * MaxStateChangesPerBatch;
+    if (state_changes > state_budget) fail("state changes", state_changes, state_budget);
+
+    size_t vertex_bytes = sprite_count * Format::VerticesPerSprite * sizeof(Format::Vertex);
+    if (gl.UploadedBytes < vertex_bytes) fail("uploaded bytes", gl.UploadedBytes, vertex_bytes);
+    // nothing else uploads during the frame, no texture is created
+    if (stats.UploadedBytes != gl.UploadedBytes) fail("stats uploaded bytes", stats.UploadedBytes, gl.UploadedBytes);
+    return ok;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t max_sprites = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    gfx::RecordingBackend backend{ gfx::RecordingBackend::Mode::Null };
+    bool ok = true;
+    std::printf("%-9s %10s %8s %8s %9s %8s %6s %6s %7s %12s\n", "sprites", "flush ms", "sort ms", "conv ms", "submit ms", "batches", "draws", "binds", "states", "upload bytes");
+
+    for (size_t sprite_count = 1000; sprite_count <= max_sprites; sprite_count *= 10) {
+        auto result = Run(backend, sprite_count, frames);
+        std::printf("%-9zu %10.3f %8.3f %8.3f %9.3f %8zu %6zu %6zu %7zu %12zu\n",
+            sprite_count, result.FlushMs, result.Stats.SortMs, result.Stats.ConvertMs, result.Stats.SubmitMs, result.Stats.Batches, result.Gl.DrawCalls,
+            result.Gl.Binds, result.Gl.StateChanges + result.Gl.ProgramSwitches, result.Gl.UploadedBytes);
+        ok = Check(sprite_count, result) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/* Compares the vertex formats of the renderer on the same scene.
+ *
+ *   SpriteBench [sprites] [frames] [--headless]
+ *
+ * Every frame submits the same translucent 8x8 sprites with DrawSprites and flushes them,
+ * glFinish included, into the offscreen target of the renderer, in a hidden window
+ * or in a surfaceless EGL context with --headless. The quad formats write 4 vertices per sprite,
+ * the point sprite format one record expanded by its geometry shader.
+ * For the software numbers run it on Mesa llvmpipe:
+ *
+ *   LIBGL_ALWAYS_SOFTWARE=1 GALLIUM_DRIVER=llvmpipe SpriteBench 50000 200 --headless
+ *
+ * Built with the game sources but Main.cpp. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "../HeadlessPlatform.h"
+#include "../Platform.h"
+#include "../gfx/Renderer.h"
+
+namespace
+{
+
+struct Result {
+    double SubmitMs; // DrawSprites and Flush, the CPU side
+    double FrameMs; // up to glFinish
+    size_t UploadBytes;
+};
+
+constexpr int Width = 1280;
+constexpr int Height = 720;
+
+template <typename VertexFormat>
+Result Run(gfx::TextureRegistry& textures, gfx::TextureHandle texture,
+    const std::vector<math::Vec2<float>>& positions, const std::vector<math::Vec2<float>>& sizes, int frames)
+{
+    // never presented, the same offscreen target with or without a window
+    gfx::Renderer<4096, VertexFormat> renderer{ Width, Height, textures };
+    renderer.Init();
+    renderer.SetPresent(false);
+
+    using clock = std::chrono::steady_clock;
+    constexpr int warmup = 10;
+    double submit_ms = 0.0;
+    double frame_ms = 0.0;
+    for (int frame = 0; frame < warmup + frames; ++frame) {
+        auto start = clock::now();
+        renderer.Clear();
+        renderer.DrawSprites(positions, sizes, texture);
+        renderer.Flush();
+        auto submitted = clock::now();
+        glFinish();
+        auto finished = clock::now();
+
+        if (frame < warmup) continue;
+        submit_ms += std::chrono::duration<double, std::milli>(submitted - start).count();
+        frame_ms += std::chrono::duration<double, std::milli>(finished - start).count();
+    }
+
+    return Result{
+        submit_ms / frames,
+        frame_ms / frames,
+        positions.size() * VertexFormat::VerticesPerSprite * sizeof(typename VertexFormat::Vertex)
+    };
+}
+
+void Print(const char* name, const Result& result)
+{
+    std::printf("%-14s %9.3f ms submit %9.3f ms frame %10zu bytes/frame\n", name, result.SubmitMs, result.FrameMs, result.UploadBytes);
+}
+
+// with a context current
+void RunAll(size_t sprite_count, int frames)
+{
+    std::printf("%s, %zu sprites, %d frames\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), sprite_count, frames);
+
+    gfx::TextureRegistry textures;
+    auto texture = textures.Create();
+    {
+        // translucent, so every format goes through the blended pass
+        auto pixels = static_cast<unsigned char*>(std::malloc(4 * 4 * 4));
+        std::fill(pixels, pixels + 4 * 4 * 4, static_cast<unsigned char>(0x80));
+        textures.Allocate(texture, gfx::Image{ 4, 4, pixels });
+    }
+
+    std::mt19937 random{ 37 };
+    std::uniform_real_distribution<float> x{ 0.0f, Width - 8.0f };
+    std::uniform_real_distribution<float> y{ 0.0f, Height - 8.0f };
+    std::vector<math::Vec2<float>> positions;
+    for (size_t i = 0; i < sprite_count; ++i) {
+        positions.push_back(math::Vec2<float>{ x(random), y(random) });
+    }
+    std::vector<math::Vec2<float>> sizes(sprite_count, math::Vec2<float>{ 8.0f, 8.0f });
+
+    Print("standard", Run<gfx::StandardVertexFormat>(textures, texture, positions, sizes, frames));
+    Print("compact", Run<gfx::CompactVertexFormat>(textures, texture, positions, sizes, frames));
+    Print("point sprite", Run<gfx::PointSpriteFormat>(textures, texture, positions, sizes, frames));
+
+    textures.Release(texture);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    size_t sprite_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+    bool headless = argc > 3 && std::string_view{ argv[3] } == "--headless";
+
+    if (headless) {
+#ifdef PLATFORM_HEADLESS
+        egl::Context context{ 3, 3 };
+        RunAll(sprite_count, frames);
+        return 0;
+#else
+        std::fprintf(stderr, "built without EGL, there is no headless context\n");
+        return 1;
+#endif
+    }
+
+    // the renderer draws offscreen, the hidden window only holds the context
+    auto library = glfw::Init();
+    glfw::WindowHints{
+        .Profile = glfw::OpenGlProfile::Core,
+        .ContextVersionMajor = 3,
+        .ContextVersionMinor = 3
+    }.Apply();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfw::Window window{ Width, Height, "SpriteBench" };
+    RunAll(sprite_count, frames);
+    return 0;
+}